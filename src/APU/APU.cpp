@@ -1,6 +1,7 @@
 #include "APU.h"
 
 #include "../Utility/Bitwise.h"
+#include "../Utility/Serializer.h"
 
 #include <iostream>
 
@@ -12,37 +13,12 @@ uint32_t APU::audio_len = 0;
 uint8_t* APU::audio_pos;
 */
 
-APU::APU()
-	: ch1(), ch2(), ch4(), newSamples(0) {
+APU::APU(const Cartridge& cartridge)
+	: cartridge(cartridge), ch1(), ch2(), ch4(), newSamples(0) {
 	
 	
 }
 
-void APU::init() {
-	// https://www.libsdl.org/release/SDL-1.2.15/docs/html/guideaudioexamples.html
-	if (SDL_Init(SDL_INIT_AUDIO) < 0) {
-		std::cerr << "Failed to initialize SDL: " << SDL_GetError() << std::endl;
-	}
-	
-	SDL_AudioSpec want, have;
-	
-	// Clear the structure
-	SDL_memset(&want, 0, sizeof(want));
-	want.freq = 44100;
-	want.format = /*AUDIO_S16SYS*/AUDIO_U8;
-	want.channels = 2;
-	want.samples = /*44100 / 60*//*4096*/1024;
-	want.callback = fill_audio;
-	want.userdata = this;
-	
-	if (SDL_OpenAudio(&want, NULL) < 0) {
-		std::cerr << "Failed to open audio: " << SDL_GetError() << std::endl;
-		SDL_Quit();
-	}
-	
-	SDL_PauseAudio(0); // Start audio playback
-}
-
 void APU::tick(uint32_t cycles) {
 	// APU Disabled
 	//if (!enabled) {
@@ -285,7 +261,7 @@ void APU::write8(uint16_t address, uint8_t data) {
 	 * but clears all APU registers and makes them read-only until turned back on, except NR521.
 	 */
 	if (!enabled && address != 0xFF26 && (address < 0xFF30) ||
-		(Cartridge::mode == Color && (address != 0xFF11 && address != 0xFF21 && 
+		(cartridge.mode == Color && (address != 0xFF11 && address != 0xFF21 && 
 					address != 0xFF31 && address != 0xFF41))) {
 		//printf("Ignoring %x\n", address);
 		return;
@@ -653,11 +629,15 @@ void APU::write8(uint16_t address, uint8_t data) {
 	}
 }
 
-// https://www.libsdl.org/release/SDL-1.2.15/docs/html/guideaudioexamples.html
-void APU::fill_audio(void* udata, Uint8* stream, int len) {
-	APU* apu = static_cast<APU*>(udata);
+void APU::generateSamples(uint8_t* stream, int len) {
+	// Leaves the stream as is (silent), and the channels where they are
+	if(!output)
+		return;
 	
-	Uint8* out = (Uint8*)stream;
+	// The locals below shadow the channels
+	APU* apu = this;
+	
+	uint8_t* out = stream;
 	//int16_t* out = (int16_t*)(stream);
 	
 	int length = len / sizeof(out[0]);
@@ -710,3 +690,65 @@ void APU::fill_audio(void* udata, Uint8* stream, int len) {
 		apu->newSamples[x++] = out[i] * 10;
 	}
 }
+
+void APU::serialize(Serializer& s) {
+	s(ticks);
+	s(counter);
+	
+	s(enabled);
+	s(vinLeft);
+	s(vinRight);
+	s(leftVolume);
+	s(rightVolume);
+	
+	/**
+	 * Where each waveform is ('ticks', 'sequencePointer') only moves in 'generateSamples',
+	 * on the audio thread, and only changes what's heard. It's saved as 0 and
+	 * kept as is on load, so the same machine always saves to the same bytes.
+	 */
+	PulseChannel pulses[2] = { ch1, ch2 };
+	
+	for(PulseChannel& pulse : pulses) {
+		pulse.ticks = 0;
+		pulse.sequencePointer = 0;
+	}
+	
+	s(pulses[0]);
+	s(pulses[1]);
+	
+	if(s.isLoading()) {
+		PulseChannel* channels[2] = { &ch1, &ch2 };
+		
+		for(int i = 0; i < 2; i++) {
+			pulses[i].ticks = channels[i]->ticks;
+			pulses[i].sequencePointer = channels[i]->sequencePointer;
+			
+			*channels[i] = pulses[i];
+		}
+	}
+	
+	s(ch4);
+	
+	// Wave has its RAM in a vector
+	s(ch3.DAC);
+	s(ch3.initialTimer);
+	s(ch3.lengthTimer);
+	s(ch3.outputLevel);
+	s(ch3.periodLow);
+	s(ch3.trigger);
+	s(ch3.lengthEnable);
+	s(ch3.periodHigh);
+	s(ch3.sweepFrequency);
+	s(ch3.period);
+	
+	// Same as the pulse channels, the output side
+	uint8_t waveSequencePointer = 0;
+	uint32_t waveTicks = 0;
+	s(waveSequencePointer);
+	s(waveTicks);
+	
+	s(ch3.enabled);
+	s(ch3.left);
+	s(ch3.right);
+	s.vector(ch3.waveform);
+}
@@ -2,12 +2,15 @@
 
 #include <deque>
 #include <queue>
-#include <SDL.h>
+#include <vector>
 
 #include "Channels/NoiseChanel.h"
 #include "Channels/PulseChannel.h"
 #include "Channels/WaveChannel.h"
 
+class Cartridge;
+class Serializer;
+
 // https://gbdev.io/pandocs/Audio.html
 
 /**
@@ -33,22 +36,35 @@
 
 class APU {
 public:
-	APU();
+	APU(const Cartridge& cartridge);
 
-	void init();
 	void tick(uint32_t cycles);
 	
 	uint8_t fetch8(uint16_t address);
 	void write8(uint16_t address, uint8_t data);
 	
-	// https://www.libsdl.org/release/SDL-1.2.15/docs/html/guideaudioexamples.html
-	static void fill_audio(void *udata, Uint8 *stream, int len);
+	// T-Cycles until the next DIV-APU step
+	uint32_t cyclesUntilFrameSequencer() const { return 8192 - ticks; }
+	
+	/**
+	 * Fills 'stream' with interleaved unsigned 8-bit,
+	 * stereo samples at 44100hz.
+	 * 
+	 * This doesn't depend on any audio device,
+	 * it's up to the frontend to call it.
+	 */
+	void generateSamples(uint8_t* stream, int len);
+	
+	// Registers and channels, not the output buffers or the frontend's toggles
+	void serialize(Serializer& s);
 	
 private:
 	
 	uint32_t ticks = 0;
 	uint8_t counter = 0;
 	
+	const Cartridge& cartridge;
+	
 public:
 	bool enabled = false;
 	bool enableAudio = false;
@@ -74,6 +90,9 @@ public:
 	bool enableCh3 = true;
 	bool enableCh4 = true;
 	
+	// Off while frames that get thrown away are run (run-ahead)
+	bool output = true;
+	
 	std::queue<uint8_t> samples;
 	std::vector<uint8_t> newSamples;
 	
@@ -1,13 +1,21 @@
 ﻿#pragma once
 
+#include <array>
 #include <cstdint>
 #include <iostream>
 #include <vector>
 
+#include "DecodeCache.h"
+#include "Profiler.h"
+
 class InterruptHandler;
 
 class MMU;
 
+class Serializer;
+
+class Tracer;
+
 // Taken from: https://gist.github.com/SakiiR/62661e45ee8b2ab13f0dc8203a7dfbd9
 
 class CPU {
@@ -17,31 +25,28 @@ public:
     uint16_t cycle();
     
     uint16_t fetchOpCode();
-    uint16_t decodeInstruction(uint16_t opcode);
-    uint16_t decodePrefix(uint16_t opcode);
+    void fetchOperands(uint8_t opcode);
     
-    void popReg(uint8_t& reg);
-    void popReg(uint8_t& high, uint8_t& low);
+    uint8_t imm8() const { return operands[0]; }
+    uint16_t imm16() const { return static_cast<uint16_t>(operands[1] << 8 | operands[0]); }
     
-    void jr(int8_t& offset);
-    
-    int jrc(int8_t& offset);
-    int jrnc(int8_t& offset);
-    
-    int jpc(uint16_t& address);
-    int jpnc(uint16_t& address);
+    uint16_t decodeInstruction(uint16_t opcode);
+    uint16_t decodePrefix(uint16_t opcode);
     
-    int callc(uint16_t& address);
-    int callnc(uint16_t& address);
+    /**
+     * Every opcode has its own handler, generated from
+     * 'execute'/'executePrefix' at compile time.
+     */
+    using Handler = uint16_t (*)(CPU&);
     
-    int jrz(int8_t& offset);
-    int jrnz(int8_t& offset);
+    template<uint8_t Op> static uint16_t execute(CPU& cpu);
+    template<uint8_t Op> static uint16_t executePrefix(CPU& cpu);
     
-    int jpz(uint16_t& address);
-    int jpnz(uint16_t& address);
+    static const std::array<Handler, 256> opcodeTable;
+    static const std::array<Handler, 256> prefixTable;
     
-    int callz(uint16_t& address);
-    int callnz(uint16_t& address);
+    void popReg(uint8_t& reg);
+    void popReg(uint8_t& high, uint8_t& low);
     
     void ld(uint8_t& regA, uint8_t& regB);
     
@@ -87,6 +92,12 @@ public:
     uint16_t popStack();
     
     void reset();
+    
+    // ROM/WRAM bank and 'pc', for the profiler and traces
+    uint32_t profileLocation(uint16_t pc) const;
+    
+    // Registers and HALT/STOP/EI state, not the decode cache
+    void serialize(Serializer& s);
 
 public:
     InterruptHandler& interruptHandler;
@@ -330,4 +341,28 @@ public:
     
     // Stack Pointer
     uint16_t SP = 0xFFFE;
+    
+    /**
+     * Operands of the current instruction,
+     * these are read before the instruction is executed;
+     * so PC already points to the next instruction.
+     */
+    uint8_t operands[2] = { 0, 0 };
+    
+    /**
+     * Code running from ROM skips the fetch/decode,
+     * by using the ROM's pre-decoded instructions.
+     * Off by default, the lookup costs as much as the fetch through
+     * the read pages does (see 'cpu/cycle' in gb_bench).
+     */
+    bool useDecodeCache = false;
+    
+    // Instructions executed, including the ones run by the recompiler
+    uint64_t instructions = 0;
+    
+    // Stays empty unless built with GB_PROFILER
+    Profiler profiler;
+    
+    // Gets every instruction while a trace is running
+    Tracer* tracer = nullptr;
 };
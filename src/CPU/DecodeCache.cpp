@@ -0,0 +1,134 @@
+#include "DecodeCache.h"
+
+#include <algorithm>
+
+#include "../Memory/RomImage.h"
+
+namespace {
+	// Same x/y/z/p/q split as in CPU.cpp
+	constexpr uint8_t opcodeLength(uint8_t op) {
+		const uint8_t x = op >> 6;
+		const uint8_t y = (op >> 3) & 7;
+		const uint8_t z = op & 7;
+		const uint8_t q = y & 1;
+		
+		if(x == 0) {
+			if(z == 0) {
+				// LD (u16), SP
+				if(y == 1) return 3;
+				
+				// JR i8/JR cc, i8
+				if(y >= 3) return 2;
+				
+				// NOP, STOP
+				return 1;
+			}
+			
+			// LD rr, u16
+			if(z == 1 && q == 0) return 3;
+			
+			// LD r, u8
+			if(z == 6) return 2;
+			
+			return 1;
+		}
+		
+		if(x == 3) {
+			switch (z) {
+			case 0:
+				// LD (FF00+u8), A/ADD SP, i8/LD A, (FF00+u8)/LD HL, SP+i8
+				return y >= 4 ? 2 : 1;
+			case 1:
+				return 1;
+			case 2:
+				// JP cc, u16/LD (u16), A/LD A, (u16)
+				if(y < 4 || y == 5 || y == 7) return 3;
+				
+				return 1;
+			case 3:
+				// JP u16
+				if(y == 0) return 3;
+				
+				// CB
+				if(y == 1) return 2;
+				
+				return 1;
+			case 4:
+				// CALL cc, u16
+				return y < 4 ? 3 : 1;
+			case 5:
+				// CALL u16
+				return y == 1 ? 3 : 1;
+			case 6:
+				// ALU A, u8
+				return 2;
+			default:
+				return 1;
+			}
+		}
+		
+		return 1;
+	}
+	
+	constexpr std::array<uint8_t, 256> makeLengths() {
+		std::array<uint8_t, 256> lengths {};
+		
+		for(int i = 0; i < 256; i++) {
+			lengths[i] = opcodeLength(static_cast<uint8_t>(i));
+		}
+		
+		return lengths;
+	}
+}
+
+const std::array<uint8_t, 256> DecodeCache::lengths = makeLengths();
+
+DecodeCache::DecodeCache(const RomImage& rom) : rom(rom) {
+	bankCount = static_cast<uint32_t>((rom.size() + 0x3FFF) >> 14);
+	banks = std::make_unique<std::atomic<const Entry*>[]>(bankCount);
+	
+	for(uint32_t bank = 0; bank < bankCount; bank++) {
+		banks[bank].store(nullptr, std::memory_order_relaxed);
+	}
+}
+
+DecodeCache::~DecodeCache() {
+	for(uint32_t bank = 0; bank < bankCount; bank++) {
+		delete[] banks[bank].load(std::memory_order_relaxed);
+	}
+}
+
+const DecodeCache::Entry* DecodeCache::decodeBank(uint32_t bank) const {
+	std::lock_guard<std::mutex> lock(mutex);
+	
+	// Someone else could've been decoding it while this waited
+	if(const Entry* entries = banks[bank].load(std::memory_order_acquire)) {
+		return entries;
+	}
+	
+	Entry* entries = new Entry[0x4000];
+	
+	// Instructions can't be followed across banks,
+	// as the next bank depends on what's mapped at that time.
+	const uint32_t start = bank << 14;
+	const uint32_t end = std::min<uint32_t>(start + 0x4000, static_cast<uint32_t>(rom.size()));
+	
+	for(uint32_t offset = start; offset < end; offset++) {
+		const uint8_t opcode = rom[offset];
+		const uint8_t length = lengths[opcode];
+		
+		if(offset + length > end) {
+			continue;
+		}
+		
+		Entry& entry = entries[offset - start];
+		entry.opcode = opcode;
+		entry.operands[0] = length > 1 ? rom[offset + 1] : 0;
+		entry.operands[1] = length > 2 ? rom[offset + 2] : 0;
+		entry.length = length;
+	}
+	
+	banks[bank].store(entries, std::memory_order_release);
+	
+	return entries;
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+class RomImage;
+
+/**
+ * Pre-decoded instructions for code running from ROM.
+ *
+ * Entries are indexed by the physical ROM offset (bank * 0x4000 + address),
+ * so a bank switch doesn't have to throw anything away,
+ * the CPU just looks the entry up with the new bank.
+ * ROM can't be written to, so entries never go stale.
+ *
+ * There's one per RomImage, shared by every GameBoy running that ROM.
+ * A 16 KB bank is decoded the first time code runs from it, most big ROMs
+ * only ever run a handful. A decoded bank never changes again,
+ * so only decoding it takes the lock, looking things up doesn't.
+ *
+ * Code running from RAM never goes through here.
+ */
+
+class DecodeCache {
+public:
+	struct Entry {
+		uint8_t opcode = 0;
+		
+		// 0 - Can't be decoded, runs past the end of the bank
+		uint8_t length = 0;
+		
+		uint8_t operands[2] = { 0, 0 };
+	};
+	
+	explicit DecodeCache(const RomImage& rom);
+	~DecodeCache();
+	
+	DecodeCache(const DecodeCache&) = delete;
+	DecodeCache& operator=(const DecodeCache&) = delete;
+	
+	/**
+	 * Returns the entry at 'offset' or nullptr,
+	 * if the instruction can't be cached, like when
+	 * it runs past the end of a bank.
+	 */
+	const Entry* lookup(uint32_t offset) const {
+		const uint32_t bank = offset >> 14;
+		
+		if(bank >= bankCount) {
+			return nullptr;
+		}
+		
+		const Entry* entries = banks[bank].load(std::memory_order_acquire);
+		
+		if(!entries) {
+			entries = decodeBank(bank);
+		}
+		
+		const Entry& entry = entries[offset & 0x3FFF];
+		
+		return entry.length != 0 ? &entry : nullptr;
+	}
+	
+	/**
+	 * Length in bytes of every opcode,
+	 * including its operands.
+	 */
+	static const std::array<uint8_t, 256> lengths;
+
+private:
+	const Entry* decodeBank(uint32_t bank) const;
+
+private:
+	const RomImage& rom;
+	uint32_t bankCount = 0;
+	
+	// Indexed by bank, nullptr until something in it runs
+	mutable std::unique_ptr<std::atomic<const Entry*>[]> banks;
+	mutable std::mutex mutex;
+};
@@ -0,0 +1,136 @@
+#include "Profiler.h"
+
+#include <algorithm>
+
+// Games that never return (popping the return address..) would grow it forever
+static const uint32_t MAX_DEPTH = 64;
+
+Profiler::Profiler() {
+	clear();
+}
+
+void Profiler::call(uint32_t location) {
+	if(paused)
+		return;
+	
+	// Past the limit, only the depth is kept track of
+	if(depth++ >= MAX_DEPTH)
+		return;
+	
+	auto it = frames[current].children.find(location);
+	
+	if(it != frames[current].children.end()) {
+		current = it->second;
+		return;
+	}
+	
+	Frame frame;
+	frame.location = location;
+	frame.parent = current;
+	
+	uint32_t index = static_cast<uint32_t>(frames.size());
+	frames[current].children[location] = index;
+	frames.push_back(std::move(frame));
+	
+	current = index;
+}
+
+void Profiler::ret() {
+	if(paused)
+		return;
+	
+	// Returning from something that was never called
+	if(depth == 0)
+		return;
+	
+	if(--depth < MAX_DEPTH)
+		current = frames[current].parent;
+}
+
+void Profiler::clear() {
+	locations.clear();
+	opcodes.fill(Counter {});
+	
+	frames.assign(1, Frame {});
+	current = 0;
+	depth = 0;
+}
+
+void Profiler::writeReport(FILE* file, size_t top) const {
+	uint64_t total = 0;
+	
+	for(const Counter& counter : opcodes) {
+		total += counter.cycles;
+	}
+	
+	if(total == 0) {
+		fprintf(file, "Nothing was profiled%s\n", enabled ? "" : " (built without GB_PROFILER)");
+		return;
+	}
+	
+	std::vector<std::pair<uint32_t, Counter>> hot(locations.begin(), locations.end());
+	
+	std::sort(hot.begin(), hot.end(), [](const auto& a, const auto& b) {
+		return a.second.cycles > b.second.cycles;
+	});
+	
+	if(hot.size() > top)
+		hot.resize(top);
+	
+	fprintf(file, "%-10s %14s %14s %8s\n", "Location", "Executions", "Cycles", "Share");
+	
+	for(const auto& [location, counter] : hot) {
+		fprintf(file, "%02X:%04X    %14llu %14llu %7.2f%%\n", location >> 16, location & 0xFFFF,
+				static_cast<unsigned long long>(counter.count), static_cast<unsigned long long>(counter.cycles),
+				100.0 * counter.cycles / total);
+	}
+	
+	std::vector<uint16_t> order;
+	
+	for(uint16_t opcode = 0; opcode < opcodes.size(); opcode++) {
+		if(opcodes[opcode].count != 0)
+			order.push_back(opcode);
+	}
+	
+	std::sort(order.begin(), order.end(), [this](uint16_t a, uint16_t b) {
+		return opcodes[a].cycles > opcodes[b].cycles;
+	});
+	
+	fprintf(file, "\n%-10s %14s %14s %8s\n", "Opcode", "Executions", "Cycles", "Share");
+	
+	for(uint16_t opcode : order) {
+		const Counter& counter = opcodes[opcode];
+		
+		if(opcode >= 0x100) fprintf(file, "CB %02X     ", opcode & 0xFF);
+		else fprintf(file, "%02X        ", opcode);
+		
+		fprintf(file, " %14llu %14llu %7.2f%%\n",
+				static_cast<unsigned long long>(counter.count), static_cast<unsigned long long>(counter.cycles),
+				100.0 * counter.cycles / total);
+	}
+}
+
+void Profiler::writeFolded(FILE* file) const {
+	std::vector<uint32_t> path;
+	writeFrame(file, 0, path);
+}
+
+void Profiler::writeFrame(FILE* file, uint32_t index, std::vector<uint32_t>& path) const {
+	const Frame& frame = frames[index];
+	
+	if(frame.cycles != 0) {
+		fprintf(file, "root");
+		
+		for(uint32_t location : path) {
+			fprintf(file, ";%02X:%04X", location >> 16, location & 0xFFFF);
+		}
+		
+		fprintf(file, " %llu\n", static_cast<unsigned long long>(frame.cycles));
+	}
+	
+	for(const auto& [location, child] : frame.children) {
+		path.push_back(location);
+		writeFrame(file, child, path);
+		path.pop_back();
+	}
+}
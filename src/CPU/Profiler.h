@@ -0,0 +1,107 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Where the emulated CPU spends its time.
+ *
+ * Counts executions and T-Cycles per location (ROM bank + PC),
+ * and per opcode (CB opcodes separately), and keeps a call tree,
+ * from CALL/RST/interrupts and RET/RETI, for flame graphs.
+ *
+ * Only compiled in with GB_PROFILER (cmake -DGB_PROFILER=ON),
+ * otherwise every GB_PROFILE(...) in the CPU compiles to nothing.
+ * Code run by the recompiler isn't seen, only the interpreter.
+ */
+
+#ifdef GB_PROFILER
+#define GB_PROFILE(...) __VA_ARGS__
+#else
+#define GB_PROFILE(...)
+#endif
+
+class Profiler {
+public:
+	struct Counter {
+		uint64_t count = 0;
+		uint64_t cycles = 0;
+	};
+
+#ifdef GB_PROFILER
+	static constexpr bool enabled = true;
+#else
+	static constexpr bool enabled = false;
+#endif
+
+	Profiler();
+	
+	/**
+	 * 'location' - (bank << 16) | PC, see 'location'
+	 * 'opcode'   - 0x000-0x0FF, or 0x100-0x1FF for CB opcodes
+	 */
+	void instruction(uint32_t location, uint16_t opcode, uint16_t cycles) {
+		if(paused)
+			return;
+		
+		Counter& counter = locations[location];
+		counter.count++;
+		counter.cycles += cycles;
+		
+		opcodes[opcode].count++;
+		opcodes[opcode].cycles += cycles;
+		
+		frames[current].cycles += cycles;
+	}
+	
+	// Entered a function (or an interrupt handler) at 'location'
+	void call(uint32_t location);
+	void ret();
+	
+	void clear();
+	
+	static uint32_t location(uint16_t bank, uint16_t pc) {
+		return static_cast<uint32_t>(bank) << 16 | pc;
+	}
+	
+	/**
+	 * The 'top' hottest locations and every opcode that ran,
+	 * sorted by cycles.
+	 */
+	void writeReport(FILE* file, size_t top = 50) const;
+	
+	/**
+	 * One line per call stack, "root;01:4000;00:0150 cycles",
+	 * what flamegraph.pl, speedscope, inferno.. take.
+	 */
+	void writeFolded(FILE* file) const;
+
+public:
+	// Nothing is counted while set, for frames that get thrown away (run-ahead)
+	bool paused = false;
+	
+	std::unordered_map<uint32_t, Counter> locations;
+	std::array<Counter, 512> opcodes;
+
+private:
+	struct Frame {
+		uint32_t location = 0;
+		uint32_t parent = 0;
+		
+		// Spent in the function itself, not in what it called
+		uint64_t cycles = 0;
+		
+		std::unordered_map<uint32_t, uint32_t> children;
+	};
+	
+	void writeFrame(FILE* file, uint32_t index, std::vector<uint32_t>& path) const;
+
+private:
+	// 0 is the root
+	std::vector<Frame> frames;
+	uint32_t current = 0;
+	uint32_t depth = 0;
+};
@@ -0,0 +1,263 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/**
+ * Tiny x86-64 encoder, only has what the recompiler needs.
+ *
+ * Generated blocks keep the CPU in rbx and the recompiler's,
+ * state in r12, everything else is addressed as [rbx/r12 + disp32].
+ *
+ * https://www.felixcloutier.com/x86/
+ */
+
+namespace x64 {
+	enum Reg : uint8_t {
+		EAX = 0, ECX = 1, EDX = 2, EBX = 3, ESP = 4, EBP = 5, ESI = 6, EDI = 7,
+		R8 = 8, R9 = 9, R10 = 10, R11 = 11, R12 = 12, R13 = 13, R14 = 14, R15 = 15
+	};
+	
+	// First 3 integer arguments
+#ifdef _WIN32
+	static constexpr Reg ARGS[3] = { ECX, EDX, R8 };
+#else
+	static constexpr Reg ARGS[3] = { EDI, ESI, EDX };
+#endif
+
+	enum Cond : uint8_t {
+		JB = 0x82, JZ = 0x84, JNZ = 0x85
+	};
+	
+	class Emitter {
+	public:
+		Emitter(uint8_t* code, size_t capacity) : code(code), capacity(capacity) {}
+		
+		size_t size() const { return pos; }
+		bool overflowed() const { return overflow; }
+		
+		void byte(uint8_t value) {
+			if(pos >= capacity) {
+				overflow = true;
+				return;
+			}
+			
+			code[pos++] = value;
+		}
+		
+		void u16(uint16_t value) { byte(value & 0xFF); byte(value >> 8); }
+		void u32(uint32_t value) { u16(value & 0xFFFF); u16(value >> 16); }
+		void u64(uint64_t value) { u32(static_cast<uint32_t>(value)); u32(static_cast<uint32_t>(value >> 32)); }
+		
+		// ModRM for [rbx + disp32]
+		void cpuMem(uint8_t reg, int32_t disp) {
+			byte(0x80 | (reg & 7) << 3 | 3);
+			u32(static_cast<uint32_t>(disp));
+		}
+		
+		// ModRM + SIB for [r12 + disp32]
+		void stateMem(uint8_t reg, int32_t disp) {
+			byte(0x80 | (reg & 7) << 3 | 4);
+			byte(0x24);
+			u32(static_cast<uint32_t>(disp));
+		}
+	
+	public:
+		void prologue() {
+			byte(0x53);                         // push rbx
+			byte(0x41); byte(0x54);             // push r12
+			byte(0x41); byte(0x55);             // push r13
+			byte(0x48); byte(0x83); byte(0xEC); byte(0x20); // sub rsp, 32 (shadow space on Windows, keeps alignment)
+			
+			movReg64(EBX, ARGS[0]);
+			movReg64(R12, ARGS[1]);
+		}
+		
+		void epilogue() {
+			byte(0x48); byte(0x83); byte(0xC4); byte(0x20); // add rsp, 32
+			byte(0x41); byte(0x5D);             // pop r13
+			byte(0x41); byte(0x5C);             // pop r12
+			byte(0x5B);                         // pop rbx
+			byte(0xC3);                         // ret
+		}
+		
+		// mov dst, src (64-bit)
+		void movReg64(Reg dst, Reg src) {
+			byte(0x48 | (src >= 8 ? 4 : 0) | (dst >= 8 ? 1 : 0));
+			byte(0x89);
+			byte(0xC0 | (src & 7) << 3 | (dst & 7));
+		}
+		
+		// mov dst, src (32-bit)
+		void movReg32(Reg dst, Reg src) {
+			if(src >= 8 || dst >= 8)
+				byte(0x40 | (src >= 8 ? 4 : 0) | (dst >= 8 ? 1 : 0));
+			
+			byte(0x89);
+			byte(0xC0 | (src & 7) << 3 | (dst & 7));
+		}
+		
+		// mov dst, imm32
+		void movImm32(Reg dst, uint32_t value) {
+			if(dst >= 8)
+				byte(0x41);
+			
+			byte(0xB8 + (dst & 7));
+			u32(value);
+		}
+		
+		// movzx dst, byte [rbx + disp]
+		void loadByte(Reg dst, int32_t disp) {
+			if(dst >= 8)
+				byte(0x44);
+			
+			byte(0x0F); byte(0xB6);
+			cpuMem(dst, disp);
+		}
+		
+		// movzx eax, word [rbx + disp]
+		void loadWord(int32_t disp) {
+			byte(0x0F); byte(0xB7);
+			cpuMem(EAX, disp);
+		}
+		
+		// mov byte [rbx + disp], al
+		void storeByte(int32_t disp) {
+			byte(0x88);
+			cpuMem(EAX, disp);
+		}
+		
+		// mov word [rbx + disp], ax
+		void storeWord(int32_t disp) {
+			byte(0x66); byte(0x89);
+			cpuMem(EAX, disp);
+		}
+		
+		// mov byte [rbx + disp], imm8
+		void storeByteImm(int32_t disp, uint8_t value) {
+			byte(0xC6);
+			cpuMem(0, disp);
+			byte(value);
+		}
+		
+		// mov word [rbx + disp], imm16
+		void storeWordImm(int32_t disp, uint16_t value) {
+			byte(0x66); byte(0xC7);
+			cpuMem(0, disp);
+			u16(value);
+		}
+		
+		// inc/dec word [rbx + disp]
+		void incWord(int32_t disp) { byte(0x66); byte(0xFF); cpuMem(0, disp); }
+		void decWord(int32_t disp) { byte(0x66); byte(0xFF); cpuMem(1, disp); }
+		
+		// test byte [rbx + disp], imm8
+		void testByte(int32_t disp, uint8_t value) {
+			byte(0xF6);
+			cpuMem(0, disp);
+			byte(value);
+		}
+		
+		// test byte [r12 + disp], imm8
+		void testStateByte(int32_t disp, uint8_t value) {
+			byte(0x41); byte(0xF6);
+			stateMem(0, disp);
+			byte(value);
+		}
+		
+		// add dword [r12 + disp], imm32
+		void addState(int32_t disp, uint32_t value) {
+			byte(0x41); byte(0x81);
+			stateMem(0, disp);
+			u32(value);
+		}
+		
+		// mov eax, dword [r12 + disp]
+		void loadStateEax(int32_t disp) {
+			byte(0x41); byte(0x8B);
+			stateMem(EAX, disp);
+		}
+		
+		// cmp eax, dword [r12 + disp]
+		void cmpStateEax(int32_t disp) {
+			byte(0x41); byte(0x3B);
+			stateMem(EAX, disp);
+		}
+		
+		// add dword [r12 + disp], eax
+		void addStateEax(int32_t disp) {
+			byte(0x41); byte(0x01);
+			stateMem(EAX, disp);
+		}
+		
+		void rolAx8() { byte(0x66); byte(0xC1); byte(0xC0); byte(0x08); } // rol ax, 8 - swaps the 2 bytes
+		void incEax() { byte(0xFF); byte(0xC0); }
+		void decEax() { byte(0xFF); byte(0xC8); }
+		void orEax(uint32_t value) { byte(0x0D); u32(value); }
+		void andEax(uint32_t value) { byte(0x25); u32(value); }
+		void movzxAx() { byte(0x0F); byte(0xB7); byte(0xC0); } // movzx eax, ax
+		void testEax() { byte(0x85); byte(0xC0); }
+		
+		void saveEax() { movReg32(R13, EAX); }                       // mov r13d, eax
+		void testSaved() { byte(0x45); byte(0x85); byte(0xED); }      // test r13d, r13d
+		
+		// mov rax, imm64; call rax
+		template<typename Function>
+		void call(Function function) {
+			static_assert(sizeof(function) == sizeof(uint64_t), "Expected a plain function pointer");
+			
+			byte(0x48); byte(0xB8);
+			
+			uint64_t address = 0;
+			std::memcpy(&address, &function, sizeof(function));
+			u64(address);
+			
+			byte(0xFF); byte(0xD0);
+		}
+	
+	public:
+		/**
+		 * Jumps are always rel32, the returned position,
+		 * gets patched with 'bind' once the target is known.
+		 */
+		size_t jump() {
+			byte(0xE9);
+			u32(0);
+			
+			return pos - 4;
+		}
+		
+		size_t jump(Cond cond) {
+			byte(0x0F); byte(cond);
+			u32(0);
+			
+			return pos - 4;
+		}
+		
+		// Throws away everything emitted after 'position'
+		void rewind(size_t position) {
+			if(position < pos)
+				pos = position;
+		}
+		
+		void bind(size_t patch) {
+			bind(patch, pos);
+		}
+		
+		void bind(size_t patch, size_t target) {
+			if(overflow)
+				return;
+			
+			int32_t rel = static_cast<int32_t>(target - (patch + 4));
+			std::memcpy(code + patch, &rel, sizeof(rel));
+		}
+	
+	private:
+		uint8_t* code;
+		size_t capacity;
+		size_t pos = 0;
+		
+		bool overflow = false;
+	};
+}
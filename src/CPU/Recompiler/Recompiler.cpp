@@ -0,0 +1,904 @@
+#include "Recompiler.h"
+
+#include <cstddef>
+#include <cstdio>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "Emitter.h"
+
+#include "../CPU.h"
+#include "../DecodeCache.h"
+#include "../../IO/InterrupHandler.h"
+#include "../../Memory/MMU.h"
+#include "../../Memory/MBC/MBC.h"
+
+using namespace x64;
+
+// Enough for a lot of games, it's all thrown away once full
+static const size_t CODE_SIZE = 16 * 1024 * 1024;
+
+static const int MAX_INSTRUCTIONS = 32;
+
+// Worst case of a single block, so it never has to be cut short
+static const size_t MAX_BLOCK_SIZE = 16 * 1024;
+
+static const int32_t PENDING = offsetof(Recompiler::State, pending);
+static const int32_t DEADLINE = offsetof(Recompiler::State, deadline);
+static const int32_t INSTRUCTIONS = offsetof(Recompiler::State, instructions);
+static const int32_t STEP_INTERRUPTS = offsetof(Recompiler::State, stepInterrupts);
+
+Recompiler::Recompiler(CPU& cpu, MMU& mmu, InterruptHandler& interruptHandler, TickCallback tick)
+	: cpu(cpu), mmu(mmu), interruptHandler(interruptHandler), tick(std::move(tick)) {
+	state.recompiler = this;
+	
+	auto disp = [&](const void* field) {
+		return static_cast<int32_t>(static_cast<const uint8_t*>(field) - reinterpret_cast<const uint8_t*>(&cpu));
+	};
+	
+	layout.reg[0] = disp(&cpu.BC.B);
+	layout.reg[1] = disp(&cpu.BC.C);
+	layout.reg[2] = disp(&cpu.DE.D);
+	layout.reg[3] = disp(&cpu.DE.E);
+	layout.reg[4] = disp(&cpu.HL.H);
+	layout.reg[5] = disp(&cpu.HL.L);
+	layout.reg[6] = 0;
+	layout.reg[7] = disp(&cpu.AF.A);
+	
+	layout.pair[0] = disp(&cpu.BC.B);
+	layout.pair[1] = disp(&cpu.DE.D);
+	layout.pair[2] = disp(&cpu.HL.H);
+	layout.pair[3] = disp(&cpu.SP);
+	
+	layout.AF = disp(&cpu.AF.A);
+	layout.F = disp(&cpu.AF.F);
+	layout.PC = disp(&cpu.PC);
+	layout.operands[0] = disp(&cpu.operands[0]);
+	layout.operands[1] = disp(&cpu.operands[1]);
+	
+	if(!isSupported())
+		return;
+
+	// Never writable and executable at once, 'compile' flips the part it emits into
+#if defined(_WIN32)
+	void* memory = VirtualAlloc(nullptr, CODE_SIZE, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+#else
+	void* memory = mmap(nullptr, CODE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	
+	if(memory == MAP_FAILED)
+		memory = nullptr;
+#endif
+
+	if(!memory) {
+		printf("[Recompiler] Couldn't allocate executable memory\n");
+		
+		return;
+	}
+	
+	code = static_cast<uint8_t*>(memory);
+	codeSize = CODE_SIZE;
+}
+
+Recompiler::~Recompiler() {
+	release();
+}
+
+void Recompiler::release() {
+	if(!code)
+		return;
+
+#if defined(_WIN32)
+	VirtualFree(code, 0, MEM_RELEASE);
+#else
+	munmap(code, codeSize);
+#endif
+	
+	code = nullptr;
+	codeSize = 0;
+	codeUsed = 0;
+	blocks.clear();
+}
+
+bool Recompiler::protect(size_t from, size_t to, bool executable) {
+	// Whole pages only
+#if defined(_WIN32)
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	const size_t page = info.dwPageSize;
+#else
+	const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+	
+	from &= ~(page - 1);
+	
+	if(to > codeSize)
+		to = codeSize;
+
+#if defined(_WIN32)
+	DWORD previous;
+	bool ok = VirtualProtect(code + from, to - from, executable ? PAGE_EXECUTE_READ : PAGE_READWRITE, &previous) != 0;
+	
+	if(ok && executable)
+		FlushInstructionCache(GetCurrentProcess(), code + from, to - from);
+#else
+	bool ok = mprotect(code + from, to - from, executable ? PROT_READ | PROT_EXEC : PROT_READ | PROT_WRITE) == 0;
+#endif
+	
+	if(!ok)
+		printf("[Recompiler] Couldn't make the code buffer %s\n", executable ? "executable" : "writable");
+	
+	return ok;
+}
+
+bool Recompiler::isSupported() {
+#if defined(__x86_64__) || defined(_M_X64)
+	return true;
+#else
+	return false;
+#endif
+}
+
+uint16_t Recompiler::run(uint32_t budget) {
+	if(!code)
+		return 0;
+	
+	// These all change how the next instruction behaves
+	if(cpu.halted || cpu.haltBug || cpu.stop || cpu.ei >= 0)
+		return 0;
+	
+	const uint16_t pc = cpu.PC;
+	
+	if(pc >= 0x8000 || mmu.bootRomActive || !mmu.dmas.empty() || mmu.enabled)
+		return 0;
+	
+	// Interrupt is about to be taken
+	if(interruptHandler.IME && (interruptHandler.IE & interruptHandler.IF))
+		return 0;
+	
+	const uint32_t offset = mmu.romBankOffset[pc >> 14] + (pc & 0x3FFF);
+	const uint32_t key = offset << 1 | (pc >> 14);
+	
+	Block block;
+	auto it = blocks.find(key);
+	
+	if(it != blocks.end()) {
+		block = it->second;
+	} else {
+		block = compile(pc, offset);
+		
+		// The buffer couldn't be protected again, the interpreter is all there is now
+		if(!code)
+			return 0;
+		
+		blocks[key] = block;
+	}
+	
+	if(!block)
+		return 0;
+	
+	state.pending = 0;
+	state.ticked = 0;
+	state.deadline = budget;
+	state.instructions = 0;
+	state.stepInterrupts = interruptHandler.IME && interruptHandler.IE != 0;
+	
+	block(&cpu, &state);
+	blocksRun++;
+	
+	cpu.instructions += state.instructions;
+	
+	return static_cast<uint16_t>(state.ticked + state.pending);
+}
+
+void Recompiler::clear() {
+	blocks.clear();
+	codeUsed = 0;
+}
+
+Recompiler::Block Recompiler::compile(uint16_t pc, uint32_t offset) {
+	if(offset >= mmu.mbc.romData().size())
+		return nullptr;
+	
+	if(codeSize - codeUsed < MAX_BLOCK_SIZE)
+		clear();
+	
+	// Only what this block can use is writable, and only while it's emitted
+	const size_t from = codeUsed;
+	const size_t to = codeUsed + MAX_BLOCK_SIZE;
+	
+	if(!protect(from, to, false)) {
+		release();
+		return nullptr;
+	}
+	
+	Block block = emit(pc, offset);
+	
+	if(!protect(from, to, true)) {
+		release();
+		return nullptr;
+	}
+	
+	return block;
+}
+
+Recompiler::Block Recompiler::emit(uint16_t pc, uint32_t offset) {
+	const RomImage& rom = mmu.mbc.romData();
+	
+	Emitter e(code + codeUsed, codeSize - codeUsed);
+	std::vector<size_t> exits;
+	
+	e.prologue();
+	
+	// Like the decode cache, never follow code into another bank
+	const uint32_t bankEnd = (offset | 0x3FFF) + 1;
+	const uint32_t end = bankEnd < rom.size() ? bankEnd : static_cast<uint32_t>(rom.size());
+	
+	int count = 0;
+	bool exited = false;
+	
+	while(count < MAX_INSTRUCTIONS && offset < end) {
+		const uint8_t opcode = rom[offset];
+		const uint8_t length = DecodeCache::lengths[opcode];
+		
+		if(offset + length > end)
+			break;
+		
+		const uint8_t low = length > 1 ? rom[offset + 1] : 0;
+		const uint8_t high = length > 2 ? rom[offset + 2] : 0;
+		const uint16_t next = static_cast<uint16_t>(pc + length);
+		
+		const size_t start = e.size();
+		e.addState(INSTRUCTIONS, 1);
+		
+		Emitted emitted = emitInstruction(e, exits, opcode, low, high, next);
+		
+		if(emitted == Emitted::Unsupported) {
+			e.rewind(start);
+			break;
+		}
+		
+		count++;
+		pc = next;
+		offset += length;
+		
+		if(emitted == Emitted::Exit) {
+			exited = true;
+			break;
+		}
+		
+		emitInterruptCheck(e, exits, next);
+	}
+	
+	if(count == 0)
+		return nullptr;
+	
+	if(!exited) {
+		e.storeWordImm(layout.PC, pc);
+		exits.push_back(e.jump());
+	}
+	
+	const size_t epilogue = e.size();
+	e.epilogue();
+	
+	for(size_t patch : exits) {
+		e.bind(patch, epilogue);
+	}
+	
+	if(e.overflowed()) {
+		printf("[Recompiler] Block at %04X didn't fit\n", pc);
+		
+		return nullptr;
+	}
+	
+	Block block = reinterpret_cast<Block>(code + codeUsed);
+	
+	// Keep blocks 16 byte aligned
+	codeUsed += (e.size() + 15) & ~static_cast<size_t>(15);
+	blocksCompiled++;
+	
+	return block;
+}
+
+/**
+ * Same x/y/z/p/q decoding as the interpreter.
+ *
+ * Simple loads and stores are done natively,
+ * and so is control flow. Everything else that only touches registers,
+ * (ALU, rotates, CB) calls the interpreter's handler for that opcode.
+ * Memory goes through 'read8'/'write8', which only tick when they have to.
+ *
+ * Cycles are always added after the memory accesses,
+ * as IO should only see the cycles of the previous instructions,
+ * just like with the interpreter.
+ */
+Recompiler::Emitted Recompiler::emitInstruction(Emitter& e, std::vector<size_t>& exits,
+												uint8_t opcode, uint8_t low, uint8_t high, uint16_t next) {
+	const uint8_t x = opcode >> 6;
+	const uint8_t y = (opcode >> 3) & 7;
+	const uint8_t z = opcode & 7;
+	const uint8_t p = y >> 1;
+	const uint8_t q = y & 1;
+	
+	const uint16_t u16 = static_cast<uint16_t>(high << 8 | low);
+	const uint16_t relative = static_cast<uint16_t>(next + static_cast<int8_t>(low));
+	
+	auto cycles = [&](uint32_t amount) {
+		e.addState(PENDING, amount);
+	};
+	
+	auto setPC = [&](uint16_t value) {
+		e.storeWordImm(layout.PC, value);
+	};
+	
+	auto exit = [&]() {
+		exits.push_back(e.jump());
+	};
+	
+	// eax = BC/DE/HL/SP
+	auto loadPair = [&](uint8_t pair) {
+		e.loadWord(layout.pair[pair]);
+		
+		if(pair != 3)
+			e.rolAx8();
+	};
+	
+	auto storePair = [&](uint8_t pair) {
+		if(pair != 3)
+			e.rolAx8();
+		
+		e.storeWord(layout.pair[pair]);
+	};
+	
+	// HL+ / HL-
+	auto stepHL = [&](bool increment) {
+		loadPair(2);
+		
+		if(increment) e.incEax();
+		else e.decEax();
+		
+		storePair(2);
+	};
+	
+	// eax = read8(eax)
+	auto read = [&]() {
+		e.movReg32(ARGS[1], EAX);
+		e.movReg64(ARGS[0], R12);
+		e.call(&Recompiler::read8);
+	};
+	
+	// write8(eax, register), r13 = whether the block has to stop
+	auto writeRegister = [&](uint8_t reg) {
+		e.movReg32(ARGS[1], EAX);
+		e.loadByte(ARGS[2], layout.reg[reg]);
+		e.movReg64(ARGS[0], R12);
+		e.call(&Recompiler::write8);
+		e.saveEax();
+	};
+	
+	auto writeImmediate = [&](uint8_t value) {
+		e.movReg32(ARGS[1], EAX);
+		e.movImm32(ARGS[2], value);
+		e.movReg64(ARGS[0], R12);
+		e.call(&Recompiler::write8);
+		e.saveEax();
+	};
+	
+	// IO or MBC writes could change pretty much anything
+	auto exitIfNeeded = [&]() {
+		e.testSaved();
+		size_t skip = e.jump(JZ);
+		
+		setPC(next);
+		exit();
+		
+		e.bind(skip);
+	};
+	
+	auto push = [&]() {
+		e.movReg32(ARGS[1], EAX);
+		e.movReg64(ARGS[0], R12);
+		e.call(&Recompiler::push16);
+	};
+	
+	auto pop = [&]() {
+		e.movReg64(ARGS[0], R12);
+		e.call(&Recompiler::pop16);
+	};
+	
+	auto setOperands = [&]() {
+		const uint8_t length = DecodeCache::lengths[opcode];
+		
+		if(length > 1) e.storeByteImm(layout.operands[0], low);
+		if(length > 2) e.storeByteImm(layout.operands[1], high);
+	};
+	
+	// Interpreter handler, adds whatever cycles it returns
+	auto handler = [&](uint8_t op) {
+		e.movReg64(ARGS[0], EBX);
+		e.call(CPU::opcodeTable[op]);
+		e.movzxAx();
+		e.addStateEax(PENDING);
+	};
+	
+	/**
+	 * Rare memory instructions (INC (HL), CB (HL)..),
+	 * everything is ticked and the handler does the access itself.
+	 */
+	auto fallback = [&]() {
+		setOperands();
+		
+		e.movReg64(ARGS[0], R12);
+		e.call(&Recompiler::flushCycles);
+		
+		handler(opcode);
+		
+		setPC(next);
+		exit();
+		
+		return Emitted::Exit;
+	};
+	
+	// NZ, Z, NC, C; returns the jump for when it's not taken
+	auto notTaken = [&](uint8_t cond) {
+		uint8_t flag;
+		
+		if(cond < 2) flag = CPU::Flags::Z;
+		else flag = CPU::Flags::C;
+		
+		e.testByte(layout.F, flag);
+		
+		return e.jump((cond & 1) ? JZ : JNZ);
+	};
+	
+	auto branch = [&](uint8_t cond, uint32_t takenCycles, uint32_t notTakenCycles, auto taken) {
+		size_t skip = notTaken(cond);
+		
+		taken();
+		cycles(takenCycles);
+		exit();
+		
+		e.bind(skip);
+		cycles(notTakenCycles);
+		setPC(next);
+		exit();
+		
+		return Emitted::Exit;
+	};
+	
+	if(x == 0) {
+		switch (z) {
+		case 0:
+			if(y == 0) {
+				// NOP
+				cycles(4);
+				
+				return Emitted::Continue;
+			}
+			
+			// LD (u16), SP
+			if(y == 1) return fallback();
+			
+			// STOP
+			if(y == 2) return Emitted::Unsupported;
+			
+			if(y == 3) {
+				// JR i8
+				cycles(12);
+				setPC(relative);
+				exit();
+				
+				return Emitted::Exit;
+			}
+			
+			// JR cc, i8
+			return branch(y - 4, 12, 8, [&]() { setPC(relative); });
+		case 1:
+			if(q == 1) {
+				// ADD HL, rr
+				handler(opcode);
+				
+				return Emitted::Continue;
+			}
+			
+			// LD rr, u16
+			if(p == 3) {
+				e.storeWordImm(layout.pair[3], u16);
+			} else {
+				e.storeByteImm(layout.pair[p], high);
+				e.storeByteImm(layout.pair[p] + 1, low);
+			}
+			
+			cycles(12);
+			
+			return Emitted::Continue;
+		case 2:
+			// LD (BC)/(DE)/(HL+)/(HL-), A and the other way around
+			loadPair(p < 2 ? p : 2);
+			
+			if(q == 0) {
+				writeRegister(7);
+			} else {
+				read();
+				e.storeByte(layout.reg[7]);
+			}
+			
+			if(p == 2) stepHL(true);
+			if(p == 3) stepHL(false);
+			
+			cycles(8);
+			
+			if(q == 0)
+				exitIfNeeded();
+			
+			return Emitted::Continue;
+		case 3:
+			// INC/DEC rr
+			if(p == 3) {
+				if(q == 0) e.incWord(layout.pair[3]);
+				else e.decWord(layout.pair[3]);
+			} else {
+				loadPair(p);
+				
+				if(q == 0) e.incEax();
+				else e.decEax();
+				
+				storePair(p);
+			}
+			
+			cycles(8);
+			
+			return Emitted::Continue;
+		case 4:
+		case 5:
+			// INC/DEC (HL)
+			if(y == 6) return fallback();
+			
+			// INC/DEC r
+			handler(opcode);
+			
+			return Emitted::Continue;
+		case 6:
+			if(y == 6) {
+				// LD (HL), u8
+				loadPair(2);
+				writeImmediate(low);
+				cycles(12);
+				exitIfNeeded();
+				
+				return Emitted::Continue;
+			}
+			
+			// LD r, u8
+			e.storeByteImm(layout.reg[y], low);
+			cycles(8);
+			
+			return Emitted::Continue;
+		default:
+			// RLCA, RRCA, RLA, RRA, DAA, CPL, SCF, CCF
+			handler(opcode);
+			
+			return Emitted::Continue;
+		}
+	}
+	
+	if(x == 1) {
+		// HALT
+		if(opcode == 0x76)
+			return Emitted::Unsupported;
+		
+		if(z == 6) {
+			// LD r, (HL)
+			loadPair(2);
+			read();
+			e.storeByte(layout.reg[y]);
+			cycles(8);
+		} else if(y == 6) {
+			// LD (HL), r
+			loadPair(2);
+			writeRegister(z);
+			cycles(8);
+			exitIfNeeded();
+		} else {
+			// LD r, r
+			e.loadByte(EAX, layout.reg[z]);
+			e.storeByte(layout.reg[y]);
+			cycles(4);
+		}
+		
+		return Emitted::Continue;
+	}
+	
+	if(x == 2) {
+		if(z == 6) {
+			// ALU A, (HL), is the same as ALU A, u8 with the value from (HL)
+			loadPair(2);
+			read();
+			e.storeByte(layout.operands[0]);
+			
+			handler(0xC6 | y << 3);
+		} else {
+			// ALU A, r
+			handler(opcode);
+		}
+		
+		return Emitted::Continue;
+	}
+	
+	switch (z) {
+	case 0:
+		// RET cc
+		if(y < 4) return branch(y, 20, 8, [&]() { pop(); e.storeWord(layout.PC); });
+		
+		if(y == 4 || y == 6) {
+			// LD (FF00+u8), A / LD A, (FF00+u8)
+			e.movImm32(EAX, 0xFF00 | low);
+			
+			if(y == 4) {
+				writeRegister(7);
+			} else {
+				read();
+				e.storeByte(layout.reg[7]);
+			}
+			
+			cycles(12);
+			
+			if(y == 4)
+				exitIfNeeded();
+			
+			return Emitted::Continue;
+		}
+		
+		// ADD SP, i8 / LD HL, SP+i8
+		setOperands();
+		handler(opcode);
+		
+		return Emitted::Continue;
+	case 1:
+		if(q == 0) {
+			// POP rr, AF instead of SP
+			pop();
+			
+			if(p == 3) {
+				e.andEax(0xFFF0);
+				e.rolAx8();
+				e.storeWord(layout.AF);
+			} else {
+				storePair(p);
+			}
+			
+			cycles(12);
+			
+			return Emitted::Continue;
+		}
+		
+		if(p == 0) {
+			// RET
+			pop();
+			e.storeWord(layout.PC);
+			cycles(16);
+			exit();
+			
+			return Emitted::Exit;
+		}
+		
+		// RETI
+		if(p == 1) return Emitted::Unsupported;
+		
+		if(p == 2) {
+			// JP HL
+			loadPair(2);
+			e.storeWord(layout.PC);
+			cycles(4);
+			exit();
+			
+			return Emitted::Exit;
+		}
+		
+		// LD SP, HL
+		handler(opcode);
+		
+		return Emitted::Continue;
+	case 2:
+		// JP cc, u16
+		if(y < 4) return branch(y, 16, 12, [&]() { setPC(u16); });
+		
+		// LD (FF00+C), A / LD (u16), A / LD A, (FF00+C) / LD A, (u16)
+		if(y == 4 || y == 6) {
+			e.loadByte(EAX, layout.reg[1]);
+			e.orEax(0xFF00);
+		} else {
+			e.movImm32(EAX, u16);
+		}
+		
+		if(y < 6) {
+			writeRegister(7);
+		} else {
+			read();
+			e.storeByte(layout.reg[7]);
+		}
+		
+		cycles((y & 1) ? 16 : 8);
+		
+		if(y < 6)
+			exitIfNeeded();
+		
+		return Emitted::Continue;
+	case 3:
+		if(y == 0) {
+			// JP u16
+			cycles(16);
+			setPC(u16);
+			exit();
+			
+			return Emitted::Exit;
+		}
+		
+		if(y == 1) {
+			// CB (HL)
+			if((low & 7) == 6) return fallback();
+			
+			setOperands();
+			handler(opcode);
+			
+			return Emitted::Continue;
+		}
+		
+		// DI, EI and illegal opcodes
+		return Emitted::Unsupported;
+	case 4:
+		// CALL cc, u16
+		if(y < 4) return branch(y, 24, 12, [&]() { e.movImm32(EAX, next); push(); setPC(u16); });
+		
+		return Emitted::Unsupported;
+	case 5:
+		if(q == 0) {
+			// PUSH rr, AF instead of SP
+			if(p == 3) {
+				e.loadWord(layout.AF);
+				e.rolAx8();
+			} else {
+				loadPair(p);
+			}
+			
+			push();
+			e.saveEax();
+			cycles(16);
+			exitIfNeeded();
+			
+			return Emitted::Continue;
+		}
+		
+		if(p == 0) {
+			// CALL u16
+			e.movImm32(EAX, next);
+			push();
+			cycles(24);
+			setPC(u16);
+			exit();
+			
+			return Emitted::Exit;
+		}
+		
+		return Emitted::Unsupported;
+	case 6:
+		// ALU A, u8
+		setOperands();
+		handler(opcode);
+		
+		return Emitted::Continue;
+	default:
+		// RST
+		e.movImm32(EAX, next);
+		push();
+		cycles(16);
+		setPC(y * 8);
+		exit();
+		
+		return Emitted::Exit;
+	}
+}
+
+/**
+ * With IME and IE set, everything gets ticked once the deadline is reached;
+ * if an interrupt is now pending, the block stops so the interpreter can take it.
+ */
+void Recompiler::emitInterruptCheck(Emitter& e, std::vector<size_t>& exits, uint16_t next) {
+	e.testStateByte(STEP_INTERRUPTS, 1);
+	size_t skip = e.jump(JZ);
+	
+	e.loadStateEax(PENDING);
+	e.cmpStateEax(DEADLINE);
+	size_t early = e.jump(JB);
+	
+	e.movReg64(ARGS[0], R12);
+	e.call(&Recompiler::checkInterrupts);
+	e.testEax();
+	size_t none = e.jump(JZ);
+	
+	e.storeWordImm(layout.PC, next);
+	exits.push_back(e.jump());
+	
+	e.bind(skip);
+	e.bind(early);
+	e.bind(none);
+}
+
+void Recompiler::flush() {
+	if(state.pending == 0)
+		return;
+	
+	state.deadline = tick(state.pending);
+	
+	state.ticked += state.pending;
+	state.pending = 0;
+}
+
+bool Recompiler::isFastMemory(uint16_t address) {
+	// Nothing else can see or change WRAM/HRAM, so those never have to tick first
+	return (address >= 0xC000 && address <= 0xDFFF) || (address >= 0xFF80 && address <= 0xFFFE);
+}
+
+uint32_t Recompiler::read8(State* state, uint32_t address) {
+	Recompiler& recompiler = *state->recompiler;
+	
+	// ROM reads don't depend on timing either
+	if(address >= 0x8000 && !isFastMemory(address))
+		recompiler.flush();
+	
+	return recompiler.mmu.fetch8(address);
+}
+
+uint32_t Recompiler::write8(State* state, uint32_t address, uint32_t value) {
+	Recompiler& recompiler = *state->recompiler;
+	
+	if(isFastMemory(address)) {
+		recompiler.mmu.write8(address, value);
+		
+		return 0;
+	}
+	
+	recompiler.flush();
+	recompiler.mmu.write8(address, value);
+	
+	return 1;
+}
+
+uint32_t Recompiler::push16(State* state, uint32_t value) {
+	CPU& cpu = state->recompiler->cpu;
+	
+	// Same order as CPU::pushToStack
+	cpu.SP--;
+	uint32_t exit = write8(state, cpu.SP, value >> 8);
+	
+	cpu.SP--;
+	exit |= write8(state, cpu.SP, value & 0xFF);
+	
+	return exit;
+}
+
+uint32_t Recompiler::pop16(State* state) {
+	CPU& cpu = state->recompiler->cpu;
+	
+	uint32_t low = read8(state, cpu.SP);
+	uint32_t high = read8(state, static_cast<uint16_t>(cpu.SP + 1));
+	
+	cpu.SP += 2;
+	
+	return high << 8 | low;
+}
+
+uint32_t Recompiler::checkInterrupts(State* state) {
+	Recompiler& recompiler = *state->recompiler;
+	recompiler.flush();
+	
+	return recompiler.interruptHandler.IE & recompiler.interruptHandler.IF;
+}
+
+void Recompiler::flushCycles(State* state) {
+	state->recompiler->flush();
+}
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+namespace x64 {
+	class Emitter;
+}
+
+class CPU;
+class MMU;
+class InterruptHandler;
+
+/**
+ * Optional x86-64 backend for the CPU.
+ *
+ * Straight-line blocks of ROM code get translated into native code,
+ * and run in one go. Blocks are keyed by where they are in the ROM,
+ * so like the decode cache, bank switches don't invalidate anything.
+ *
+ * Cycles are batched and only handed to the rest of the system ('tick'),
+ * right before an access outside ROM/WRAM/HRAM and when a block exits.
+ * While interrupts could fire (IME and IE are set), cycles are also flushed,
+ * after the instruction that reaches the next scheduled event,
+ * so interrupts are still taken at the exact same instruction.
+ *
+ * Anything that can't be done in a block (EI/DI/HALT/STOP/RETI, the boot ROM,
+ * pending interrupts, DMA, HDMA, code in RAM) is left to the interpreter.
+ */
+
+class Recompiler {
+public:
+	// Ticks everything else, returns the T-Cycles until the next scheduled event
+	using TickCallback = std::function<uint32_t(uint32_t cycles)>;
+	
+	Recompiler(CPU& cpu, MMU& mmu, InterruptHandler& interruptHandler, TickCallback tick);
+	~Recompiler();
+	
+	Recompiler(const Recompiler&) = delete;
+	Recompiler& operator=(const Recompiler&) = delete;
+	
+	// False if this isn't a x86-64 build or the code buffer couldn't be allocated
+	static bool isSupported();
+	bool isAvailable() const { return code != nullptr; }
+	
+	/**
+	 * Runs one block at PC, 'budget' being the T-Cycles,
+	 * until the next scheduled event.
+	 *
+	 * Returns the total T-Cycles it took, or 0 if,
+	 * the interpreter has to run the next instruction.
+	 * The last 'pendingCycles()' of those haven't been ticked yet.
+	 */
+	uint16_t run(uint32_t budget);
+	
+	uint32_t pendingCycles() const { return state.pending; }
+	
+	// Throws away every compiled block
+	void clear();
+
+public:
+	/**
+	 * Everything generated code touches,
+	 * lives in here, addressed through r12.
+	 */
+	struct State {
+		// Cycles not ticked yet
+		uint32_t pending = 0;
+		
+		// Cycles ticked during this block
+		uint32_t ticked = 0;
+		
+		// Once 'pending' reaches this, something could've happened
+		uint32_t deadline = 0;
+		
+		// Instructions run during this block
+		uint32_t instructions = 0;
+		
+		// IME && IE, so the deadline has to be checked every instruction
+		uint8_t stepInterrupts = 0;
+		
+		Recompiler* recompiler = nullptr;
+	};
+	
+	using Block = void (*)(CPU* cpu, State* state);
+	
+	uint64_t blocksCompiled = 0;
+	uint64_t blocksRun = 0;
+
+private:
+	enum class Emitted {
+		Continue,
+		
+		// Instruction ends the block
+		Exit,
+		
+		// Nothing was emitted, the interpreter has to run this one
+		Unsupported
+	};
+	
+	// Makes room for the block writable, emits it, then makes it executable again
+	Block compile(uint16_t pc, uint32_t offset);
+	Block emit(uint16_t pc, uint32_t offset);
+	
+	// Code buffer bytes 'from' to 'to', either read+write or read+execute
+	bool protect(size_t from, size_t to, bool executable);
+	
+	// Frees the code buffer, after which only the interpreter runs
+	void release();
+	
+	Emitted emitInstruction(x64::Emitter& e, std::vector<size_t>& exits,
+							uint8_t opcode, uint8_t low, uint8_t high, uint16_t next);
+	void emitInterruptCheck(x64::Emitter& e, std::vector<size_t>& exits, uint16_t next);
+	
+	void flush();
+	
+	// Called from generated code
+	static uint32_t read8(State* state, uint32_t address);
+	static uint32_t write8(State* state, uint32_t address, uint32_t value);
+	static uint32_t push16(State* state, uint32_t value);
+	static uint32_t pop16(State* state);
+	static uint32_t checkInterrupts(State* state);
+	static void flushCycles(State* state);
+	
+	static bool isFastMemory(uint16_t address);
+
+private:
+	CPU& cpu;
+	MMU& mmu;
+	InterruptHandler& interruptHandler;
+	
+	TickCallback tick;
+	
+	State state;
+	
+	/**
+	 * Where the registers are, relative to the CPU.
+	 * BC/DE/HL are stored high byte first.
+	 */
+	struct Layout {
+		int32_t reg[8];  // B, C, D, E, H, L, -, A
+		int32_t pair[4]; // BC, DE, HL, SP
+		int32_t AF;
+		int32_t F;
+		int32_t PC;
+		int32_t operands[2];
+	} layout;
+	
+	uint8_t* code = nullptr;
+	size_t codeSize = 0;
+	size_t codeUsed = 0;
+	
+	// (ROM offset << 1 | PC >> 14) -> Block, nullptr if it couldn't be compiled
+	std::unordered_map<uint32_t, Block> blocks;
+};
@@ -0,0 +1,608 @@
+#include "GameBoy.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <utility>
+
+#include "../Utility/Serializer.h"
+
+static const double CLOCK_SPEED_NORMAL = 4194304; // 4.194304 MHz
+static const double CLOCK_SPEED_DOUBLE = 8388608; // 8.388608 MHz
+static const int FPS = 60;
+
+// Most a single step fast-forwards by
+static const uint32_t MAX_SKIP = 0x4000;
+
+// Bump whenever anything is added to/removed from a 'serialize'
+static const char STATE_MAGIC[4] = { 'G', 'B', 'S', 'T' };
+static const uint16_t STATE_VERSION = 2;
+
+struct StateHeader {
+	char magic[4];
+	uint16_t version;
+	
+	// Everything, including this header
+	uint32_t size;
+	
+	// Which ROM the state belongs to
+	uint32_t romSize;
+	uint8_t romChecksum[3];
+};
+
+static StateHeader makeStateHeader(const RomImage& rom) {
+	StateHeader header = {};
+	std::memcpy(header.magic, STATE_MAGIC, sizeof(STATE_MAGIC));
+	header.version = STATE_VERSION;
+	header.romSize = static_cast<uint32_t>(rom.size());
+	
+	// Header checksum (0x14D) and global checksum (0x14E-0x14F)
+	if(rom.size() >= 0x150)
+		std::memcpy(header.romChecksum, rom.data() + 0x14D, sizeof(header.romChecksum));
+	
+	return header;
+}
+
+static Cartridge decodeCartridge(const RomHandle& rom) {
+	Cartridge cartridge;
+	cartridge.decode(*rom);
+	
+	return cartridge;
+}
+
+GameBoy::GameBoy(const std::vector<uint8_t>& rom, const std::vector<uint8_t>& bootRom)
+	: GameBoy(RomImage::fromBytes(rom), bootRom) {
+	
+}
+
+GameBoy::GameBoy(RomHandle rom, const std::vector<uint8_t>& bootRom)
+	: cartridge(decodeCartridge(rom)),
+	  mbc(cartridge, rom),
+	  vram(lcdc, cartridge),
+	  apu(cartridge),
+	  mmu(interruptHandler, serial, joypad, mbc, wram,
+		  hram, vram, lcdc, timer, oam, ppu,
+		  apu, cartridge, bootRom),
+	  ppu(vram, oam, lcdc, mmu, cartridge),
+	  cpu(interruptHandler, mmu) {
+	mmu.sync = [this](bool write) {
+		flush();
+		
+		if(write)
+			ioWritten = true;
+	};
+	
+	schedule();
+}
+
+uint16_t GameBoy::step() {
+	const uint16_t pc = cpu.PC;
+	const uint64_t start = scheduler.cycles + pending;
+	
+	uint16_t cycles = 0;
+	
+	if(cpu.halted)
+		cycles = skipHalt();
+	
+	if(cycles == 0 && recompiler) {
+		// A whole block, some of which might've been ticked already
+		cycles = recompiler->run(cyclesUntilEvent());
+		
+		if(cycles != 0)
+			pending += recompiler->pendingCycles();
+	}
+	
+	if(cycles == 0) {
+		cycles = cpu.cycle();
+		pending += cycles;
+	}
+	
+	if(needsFlush())
+		flush();
+	
+	// Jumped backwards, might be waiting on something
+	if(skipIdleLoops && cpu.PC <= pc) {
+		uint16_t skipped = skipIdleLoop(pc, start);
+		
+		if(skipped != 0) {
+			cycles += skipped;
+			
+			if(needsFlush())
+				flush();
+		}
+	}
+	
+	recent[0] = recent[1];
+	recent[1] = { pc, start };
+	
+	return cycles;
+}
+
+bool GameBoy::needsFlush() const {
+	/**
+	 * STOP counts down in 'tick', and joypad interrupts,
+	 * come from the frontend, so those can't wait either.
+	 */
+	return scheduler.cycles + pending >= scheduler.next() || ioWritten || cpu.stop || joypad.interrupt;
+}
+
+uint8_t GameBoy::pendingInterrupts() const {
+	/**
+	 * 'Joypad::setState' runs between frames, its interrupt only reaches IF
+	 * at the next flush, which a skip would push back by up to MAX_SKIP.
+	 */
+	return (interruptHandler.IF | joypad.interrupt) & interruptHandler.IE;
+}
+
+/**
+ * A halted CPU does nothing but burn 4 T-Cycles a step,
+ * until an interrupt is requested, which can only happen at the next event.
+ * So all of those steps are done at once.
+ */
+uint16_t GameBoy::skipHalt() {
+	if(cpu.ei >= 0 || cpu.stop || pendingInterrupts())
+		return 0;
+	
+	uint32_t cycles = (cyclesUntilEvent() + 3) & ~3u;
+	
+	if(cycles < 4) cycles = 4;
+	if(cycles > MAX_SKIP) cycles = MAX_SKIP;
+	
+	pending += cycles;
+	haltCyclesSkipped += cycles - 4;
+	
+	return static_cast<uint16_t>(cycles);
+}
+
+/**
+ * Polling loops like;
+ * 
+ * loop:
+ *	LDH A, (0xFF44)
+ *	CP 0x90
+ *	JR NZ, loop
+ * 
+ * Only ever load A, test it, and jump back. If nothing changed,
+ * since the last iteration read its value, the next ones will read,
+ * the same thing until the next event, so those are skipped as a whole.
+ * 
+ * 'pc' and 'start' are where/when the step that just ran began.
+ */
+uint16_t GameBoy::skipIdleLoop(uint16_t pc, uint64_t start) {
+	const uint16_t head = cpu.PC;
+	IdleLoop loop;
+	
+	if(cpu.halted || cpu.ei >= 0 || !matchIdleLoop(head, loop))
+		return 0;
+	
+	// About to take an interrupt
+	if(interruptHandler.IME && pendingInterrupts())
+		return 0;
+	
+	// When the last iteration started, either as one block or instruction by instruction
+	uint64_t iterationStart;
+	
+	if(pc == head) {
+		iterationStart = start;
+	} else if(pc == head + loop.jump && recent[1].pc == head + loop.test && recent[0].pc == head) {
+		iterationStart = recent[0].start;
+	} else {
+		return 0;
+	}
+	
+	if(lastChange > iterationStart)
+		return 0;
+	
+	const uint64_t now = scheduler.cycles + pending;
+	const uint32_t speed = mmu.doubleSpeed ? 2 : 1;
+	
+	uint64_t budget = cyclesUntilEvent();
+	
+	// DIV/TIMA change without an event
+	if(loop.address == 0xFF04 || loop.address == 0xFF05) {
+		uint64_t change = scheduler.cycles + (timer.cyclesUntilIncrement() + speed - 1) / speed;
+		
+		if(change <= now)
+			return 0;
+		
+		if(change - now < budget)
+			budget = change - now;
+	}
+	
+	const uint32_t period = static_cast<uint32_t>(now - iterationStart);
+	
+	if(budget > MAX_SKIP)
+		budget = MAX_SKIP;
+	
+	const uint32_t cycles = static_cast<uint32_t>(budget / period) * period;
+	
+	pending += cycles;
+	idleCyclesSkipped += cycles;
+	
+	return static_cast<uint16_t>(cycles);
+}
+
+bool GameBoy::matchIdleLoop(uint16_t head, IdleLoop& loop) {
+	// Never read code out of IO
+	if(head >= 0xFF00 - 8)
+		return false;
+	
+	/**
+	 * This runs on every backward jump, HALT and interrupt, so it only peeks,
+	 * that keeps it out of 'mmu.reads' and off the DMA conflict path,
+	 * and most of the time the first byte already rules it out.
+	 */
+	uint8_t code[8];
+	code[0] = mmu.peek(head);
+	
+	if(code[0] != 0xF0 && code[0] != 0xFA && code[0] != 0x7E)
+		return false;
+	
+	for(uint8_t i = 1; i < 8; i++) {
+		code[i] = mmu.peek(static_cast<uint16_t>(head + i));
+	}
+	
+	uint8_t at;
+	
+	switch (code[0]) {
+	case 0xF0: // LDH A, (FF00+u8)
+		loop.address = 0xFF00 | code[1];
+		at = 2;
+		break;
+	case 0xFA: // LD A, (u16)
+		loop.address = static_cast<uint16_t>(code[2] << 8 | code[1]);
+		at = 3;
+		break;
+	case 0x7E: // LD A, (HL)
+		loop.address = cpu.HL.get();
+		at = 1;
+		break;
+	default:
+		return false;
+	}
+	
+	loop.test = at;
+	
+	switch (code[at]) {
+	case 0xFE: case 0xE6: case 0xF6: case 0xEE: // CP/AND/OR/XOR u8
+		at += 2;
+		break;
+	case 0xB7: case 0xA7: // OR A/AND A
+		at += 1;
+		break;
+	case 0xCB: // BIT n, A
+		if((code[at + 1] & 0xC7) != 0x47)
+			return false;
+		
+		at += 2;
+		break;
+	default:
+		return false;
+	}
+	
+	loop.jump = at;
+	
+	// JR cc, back to the load
+	const uint8_t jump = code[at];
+	
+	if(jump != 0x20 && jump != 0x28 && jump != 0x30 && jump != 0x38)
+		return false;
+	
+	if(static_cast<int8_t>(code[at + 1]) != -(at + 2))
+		return false;
+	
+	return isIdleSafe(loop.address);
+}
+
+/**
+ * Whether 'address' can only change at a scheduled event,
+ * or when the CPU itself writes to it.
+ */
+bool GameBoy::isIdleSafe(uint16_t address) {
+	// Cartridge RAM, could be the RTC
+	if(address >= 0xA000 && address <= 0xBFFF)
+		return false;
+	
+	// DIV, TIMA, IF, STAT, LY
+	if(address >= 0xFF00 && address <= 0xFF7F)
+		return address == 0xFF04 || address == 0xFF05 || address == 0xFF0F || address == 0xFF41 || address == 0xFF44;
+	
+	return true;
+}
+
+void GameBoy::flush() {
+	// Anything the CPU sees could be different after this
+	if(ioWritten || joypad.interrupt || scheduler.cycles + pending >= scheduler.next())
+		lastChange = scheduler.cycles + pending;
+	
+	ioWritten = false;
+	
+	if(pending == 0)
+		return;
+	
+	// Cleared first, DMAs can end up back in here through 'mmu.sync'
+	uint32_t cycles = pending;
+	pending = 0;
+	
+	tick(cycles);
+	
+	scheduler.cycles += cycles;
+	scheduler.flushes++;
+	
+	schedule();
+}
+
+void GameBoy::schedule() {
+	const uint64_t now = scheduler.cycles;
+	const uint32_t speed = mmu.doubleSpeed ? 2 : 1;
+	
+	// The PPU runs at half the speed, the timer at double
+	uint32_t dots = ppu.cyclesUntilEvent();
+	
+	if(dots == UINT32_MAX) scheduler.cancel(Scheduler::PPUMode);
+	else scheduler.schedule(Scheduler::PPUMode, now + static_cast<uint64_t>(dots) * speed);
+	
+	uint32_t timerCycles = timer.cyclesUntilOverflow();
+	
+	if(timerCycles == UINT32_MAX) scheduler.cancel(Scheduler::TimerOverflow);
+	else scheduler.schedule(Scheduler::TimerOverflow, now + (timerCycles + speed - 1) / speed);
+	
+	scheduler.schedule(Scheduler::FrameSequencer, now + apu.cyclesUntilFrameSequencer());
+	
+	/**
+	 * DMAs can't be batched up, and neither can anything
+	 * right before a speed switch, as 'tick' scales by the current speed.
+	 */
+	if(!mmu.dmas.empty() || mmu.enabled || mmu.switchArmed) scheduler.schedule(Scheduler::DMA, now);
+	else scheduler.cancel(Scheduler::DMA);
+}
+
+void GameBoy::settle() {
+	flush();
+	schedule();
+	
+	lastChange = scheduler.cycles;
+	recent[0] = recent[1] = {};
+}
+
+uint32_t GameBoy::cyclesUntilEvent() const {
+	const uint64_t now = scheduler.cycles + pending;
+	
+	if(now >= scheduler.next())
+		return 0;
+	
+	uint64_t cycles = scheduler.next() - now;
+	
+	return cycles > UINT32_MAX ? UINT32_MAX : static_cast<uint32_t>(cycles);
+}
+
+void GameBoy::tick(uint32_t cycles) {
+	if(cpu.stop) {
+		cpu.stopTimer -= cycles;
+		
+		if(cpu.stopTimer <= 0) {
+			cpu.stop = false;
+		}
+	}
+	
+	// TODO; I'm unsure about the order, but this makes sense?
+	timer.tick(cycles * (mmu.doubleSpeed ? 2 : 1), !cpu.stop);
+	
+	mmu.tick(cycles);
+	ppu.tick((cycles / (mmu.doubleSpeed ? 2 : 1)) + mmu.cycles);
+	
+	mmu.cycles = 0;
+	
+	// Apply interrupts
+	interruptHandler.IF |= timer.interrupt;
+	timer.interrupt = 0;
+	
+	interruptHandler.IF |= joypad.interrupt;
+	joypad.interrupt = 0;
+	
+	interruptHandler.IF |= ppu.interrupt;
+	ppu.interrupt = 0;
+	
+	interruptHandler.IF |= serial.interrupt;
+	serial.interrupt = 0;
+}
+
+bool GameBoy::setBackend(Backend backend) {
+	if(backend == Backend::Interpreter) {
+		recompiler.reset();
+		
+		return true;
+	}
+	
+	if(recompiler)
+		return true;
+	
+	if(!Recompiler::isSupported()) {
+		printf("[GameBoy] Recompiler is only supported on x86-64\n");
+		
+		return false;
+	}
+	
+	recompiler = std::make_unique<Recompiler>(cpu, mmu, interruptHandler, [this](uint32_t cycles) {
+		pending += cycles;
+		flush();
+		
+		return cyclesUntilEvent();
+	});
+	
+	if(!recompiler->isAvailable()) {
+		recompiler.reset();
+		
+		return false;
+	}
+	
+	return true;
+}
+
+void GameBoy::runFrame() {
+	while(!frameDone()) {
+		frameCycles += step();
+	}
+	
+	endFrame();
+}
+
+void GameBoy::saveState(std::vector<uint8_t>& out) {
+	// Nothing can be left half ticked, and carrying on has to look like a load
+	settle();
+	writeState(out);
+}
+
+void GameBoy::snapshot(std::vector<uint8_t>& out) {
+	flush();
+	writeState(out);
+}
+
+void GameBoy::writeState(std::vector<uint8_t>& out) {
+	StateHeader header = makeStateHeader(mbc.romData());
+	
+	out.clear();
+	
+	Serializer s(out);
+	s(header);
+	serialize(s);
+	
+	header.size = static_cast<uint32_t>(out.size());
+	std::memcpy(out.data(), &header, sizeof(header));
+}
+
+bool GameBoy::loadState(const uint8_t* data, size_t size, bool trusted) {
+	const StateHeader expected = makeStateHeader(mbc.romData());
+	StateHeader header = {};
+	
+	if(size < sizeof(header)) {
+		printf("[GameBoy] Save state is too small\n");
+		return false;
+	}
+	
+	std::memcpy(&header, data, sizeof(header));
+	
+	if(std::memcmp(header.magic, expected.magic, sizeof(header.magic)) != 0 || header.version != STATE_VERSION) {
+		printf("[GameBoy] Not a save state, or from a different version\n");
+		return false;
+	}
+	
+	if(header.size != size) {
+		printf("[GameBoy] Save state is %zu bytes, expected %u\n", size, header.size);
+		return false;
+	}
+	
+	if(header.romSize != expected.romSize || std::memcmp(header.romChecksum, expected.romChecksum, sizeof(header.romChecksum)) != 0) {
+		printf("[GameBoy] Save state is for a different ROM\n");
+		return false;
+	}
+	
+	// A corrupted state can fail halfway through, so keep what's here to go back to
+	std::vector<uint8_t> backup;
+	
+	if(!trusted)
+		saveState(backup);
+	
+	Serializer s(data + sizeof(header), size - sizeof(header));
+	serialize(s);
+	
+	if(!s.good() || s.offset() != size - sizeof(header)) {
+		printf("[GameBoy] Save state is corrupted\n");
+		
+		if(!trusted) {
+			Serializer restore(backup.data() + sizeof(header), backup.size() - sizeof(header));
+			serialize(restore);
+		}
+	}
+	
+	const bool loaded = s.good() && s.offset() == size - sizeof(header);
+	
+	// Nothing that's derived from the state carries over
+	pending = 0;
+	ioWritten = false;
+	
+	mmu.updatePages();
+	settle();
+	
+	return loaded;
+}
+
+void GameBoy::runAhead(uint32_t frames) {
+	if(frames == 0) {
+		aheadPixels.clear();
+		return;
+	}
+	
+	auto start = std::chrono::steady_clock::now();
+	
+	saveState(aheadState);
+	
+	apu.output = false;
+	
+	// None of this really happens, so nothing outside gets to see it
+	SerialCallback serialCallback = serial.take_callback();
+	Tracer* tracer = std::exchange(cpu.tracer, nullptr);
+	MMU::WriteHook writeHook = std::exchange(mmu.writeHook, nullptr);
+	cpu.profiler.paused = true;
+	
+	if(writeHook)
+		mmu.updatePages();
+	
+	/**
+	 * Only the last one is ever shown, but a frame is a bit shorter,
+	 * than the screen takes to draw, so it doesn't redraw every line.
+	 * (With the LCD off for a while, lines from further back can stay)
+	 */
+	for(uint32_t i = 0; i < frames; i++) {
+		ppu.render = i + 2 >= frames;
+		runFrame();
+	}
+	
+	aheadPixels.assign(std::begin(ppu.pixels), std::end(ppu.pixels));
+	
+	ppu.render = true;
+	apu.output = true;
+	
+	loadState(aheadState, true);
+	
+	serial.set_callback(std::move(serialCallback));
+	cpu.tracer = tracer;
+	mmu.writeHook = std::move(writeHook);
+	cpu.profiler.paused = false;
+	
+	if(mmu.writeHook)
+		mmu.updatePages();
+	
+	runAheadMicros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+
+const uint32_t* GameBoy::screen() const {
+	return aheadPixels.empty() ? ppu.pixels : aheadPixels.data();
+}
+
+void GameBoy::serialize(Serializer& s) {
+	s(scheduler.cycles);
+	s(frameCycles);
+	
+	cpu.serialize(s);
+	mmu.serialize(s);
+	mbc.serialize(s);
+	
+	interruptHandler.serialize(s);
+	timer.serialize(s);
+	joypad.serialize(s);
+	serial.serialize(s);
+	
+	wram.serialize(s);
+	hram.serialize(s);
+	vram.serialize(s);
+	oam.serialize(s);
+	
+	lcdc.serialize(s);
+	ppu.serialize(s);
+	apu.serialize(s);
+}
+
+double GameBoy::cyclesPerFrame() const {
+	return mmu.doubleSpeed ? CLOCK_SPEED_DOUBLE / FPS : CLOCK_SPEED_NORMAL / FPS;
+}
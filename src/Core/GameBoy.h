@@ -0,0 +1,256 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "../APU/APU.h"
+#include "../CPU/CPU.h"
+#include "../CPU/Recompiler/Recompiler.h"
+
+#include "Scheduler.h"
+
+#include "../IO/InterrupHandler.h"
+#include "../IO/Joypad.h"
+#include "../IO/Serial.h"
+#include "../IO/Timer.h"
+
+#include "../Memory/Cartridge.h"
+#include "../Memory/MMU.h"
+#include "../Memory/HRAM.h"
+#include "../Memory/WRAM.h"
+#include "../Memory/MBC/MBC.h"
+
+#include "../Pipeline/PPU.h"
+#include "../Pipeline/LCDC.h"
+#include "../Pipeline/VRAM.h"
+#include "../Pipeline/OAM.h"
+
+class Serializer;
+
+/**
+ * Owns a whole Game Boy.
+ *
+ * Every component only holds references into this object,
+ * so the members are declared in the order they need to be built.
+ * Nothing in here is shared between instances, so each GameBoy,
+ * can be stepped on its own thread.
+ */
+
+enum class Backend {
+	Interpreter,
+	
+	// x86-64 only, see Recompiler
+	Recompiler
+};
+
+class GameBoy {
+public:
+	/**
+	 * The ROM is shared, so any number of instances
+	 * can run the same image without copying it.
+	 */
+	GameBoy(RomHandle rom, const std::vector<uint8_t>& bootRom);
+	
+	// Copies the ROM into its own image
+	GameBoy(const std::vector<uint8_t>& rom, const std::vector<uint8_t>& bootRom);
+	
+	// Everything references everything, so no copying/moving
+	GameBoy(const GameBoy&) = delete;
+	GameBoy& operator=(const GameBoy&) = delete;
+	
+	/**
+	 * Runs a single instruction (or a whole block with the recompiler).
+	 * 
+	 * Everything else only gets ticked once the next scheduled event,
+	 * is reached, or right before the CPU touches IO,
+	 * so from the outside it looks like it got ticked every instruction.
+	 * 
+	 * A HALT with nothing pending, or a loop polling something,
+	 * that can't change before the next event, is fast-forwarded,
+	 * so this can return a lot more than one instruction's worth.
+	 * 
+	 * Returns the amount of T-Cycles it took.
+	 */
+	uint16_t step();
+	
+	/**
+	 * Ticks everything but the CPU,
+	 * by the given amount of T-Cycles.
+	 */
+	void tick(uint32_t cycles);
+	
+	/**
+	 * Ticks everything by the cycles the CPU is ahead,
+	 * and reschedules all the events.
+	 */
+	void flush();
+	
+	// T-Cycles the CPU can still run before something has to be ticked
+	uint32_t cyclesUntilEvent() const;
+	
+	// T-Cycles since power on, including the ones not ticked yet
+	uint64_t cycles() const { return scheduler.cycles + pending; }
+	
+	/**
+	 * Ticks everything, and forgets what the idle loop detection has seen,
+	 * so how things run from here on only depends on the state.
+	 * Save states do this, movies do it every frame.
+	 */
+	void settle();
+	
+	/**
+	 * Can be switched at any point between steps.
+	 * Returns false if the recompiler isn't available,
+	 * in which case it stays on the interpreter.
+	 */
+	bool setBackend(Backend backend);
+	Backend getBackend() const { return recompiler ? Backend::Recompiler : Backend::Interpreter; }
+	
+	// Runs roughly one frame worth of cycles
+	void runFrame();
+	
+	double cyclesPerFrame() const;
+	
+	/**
+	 * Where 'runFrame' ends a frame, for frontends that step on their own.
+	 * The speed is checked every time, a CGB game can switch halfway through,
+	 * and movies only play back right if frames end on the same cycle.
+	 */
+	bool frameDone() const { return frameCycles >= cyclesPerFrame(); }
+	
+	// Starts the next frame, skipped HALTs/loops can run over, that goes into it
+	void endFrame() { frameCycles -= static_cast<uint64_t>(cyclesPerFrame()); }
+	
+	/**
+	 * Save states, everything needed to carry on from exactly here.
+	 * 
+	 * The ROM and the boot ROM aren't included,
+	 * so a state can only be loaded into a GameBoy with the same ROM.
+	 * Loading checks that first, and leaves everything as is,
+	 * if the state doesn't fit (returns false).
+	 * 
+	 * 'trusted' - The state came from 'saveState' on this GameBoy (rewind, run-ahead..),
+	 * so there's no backup taken to go back to if it turns out to be corrupted.
+	 */
+	void saveState(std::vector<uint8_t>& out);
+	bool loadState(const uint8_t* data, size_t size, bool trusted = false);
+	bool loadState(const std::vector<uint8_t>& data, bool trusted = false) { return loadState(data.data(), data.size(), trusted); }
+	
+	/**
+	 * The same bytes 'saveState' writes, but only flushed, not settled,
+	 * so the idle loop detection keeps what it's seen and carries on as if nothing happened.
+	 * For comparing against another GameBoy, as often as every instruction.
+	 */
+	void snapshot(std::vector<uint8_t>& out);
+	
+	/**
+	 * Run-ahead, hides 'frames' frames of input lag.
+	 * 
+	 * Runs 'frames' frames past the current one, with the current input,
+	 * without audio and only drawing the last one, keeps that picture,
+	 * then goes back to where it was. Call it after every real frame,
+	 * the picture is then what 'screen' returns, 0 turns it back off.
+	 * The serial callback, tracer, write hook and profiler don't see those frames.
+	 */
+	void runAhead(uint32_t frames);
+	
+	// Picture to show, the run-ahead one if there is one
+	const uint32_t* screen() const;
+	
+public:
+	Cartridge cartridge;
+	MBC mbc;
+	
+	InterruptHandler interruptHandler;
+	
+	// I/O
+	LCDC lcdc;
+	Joypad joypad;
+	Serial serial;
+	Timer timer;
+	
+	OAM oam;
+	
+	// Memories
+	WRAM wram;
+	HRAM hram;
+	VRAM vram;
+	
+	APU apu;
+	
+	/**
+	 * MMU and PPU point at each other,
+	 * the MMU only stores the reference,
+	 * so it's fine that PPU is built after it.
+	 */
+	MMU mmu;
+	PPU ppu;
+	
+	CPU cpu;
+	
+	// Only exists while the recompiler is in use
+	std::unique_ptr<Recompiler> recompiler;
+	
+	Scheduler scheduler;
+	
+	uint64_t frameCycles = 0;
+	
+	// Skip polling loops (LY/STAT/DIV..) until whatever they're waiting on
+	bool skipIdleLoops = true;
+	
+	// T-Cycles that were fast-forwarded
+	uint64_t haltCyclesSkipped = 0;
+	uint64_t idleCyclesSkipped = 0;
+	
+	// How long the last 'runAhead' took
+	double runAheadMicros = 0;
+
+private:
+	struct IdleLoop {
+		// What gets polled
+		uint16_t address = 0;
+		
+		// Offsets of the test and the jump from the start of the loop
+		uint8_t test = 0;
+		uint8_t jump = 0;
+	};
+	
+	void schedule();
+	bool needsFlush() const;
+	
+	// Requested and enabled, including a joypad interrupt that hasn't been flushed into IF yet
+	uint8_t pendingInterrupts() const;
+	
+	uint16_t skipHalt();
+	uint16_t skipIdleLoop(uint16_t pc, uint64_t start);
+	bool matchIdleLoop(uint16_t head, IdleLoop& loop);
+	
+	static bool isIdleSafe(uint16_t address);
+	
+	// Every component, in a fixed order
+	void serialize(Serializer& s);
+	
+	// Header and everything, for 'saveState'/'snapshot'
+	void writeState(std::vector<uint8_t>& out);
+
+private:
+	// T-Cycles the CPU ran that haven't been ticked yet
+	uint32_t pending = 0;
+	
+	// IO was written to, anything could've changed
+	bool ioWritten = false;
+	
+	// Last time something was ticked the CPU could notice
+	uint64_t lastChange = 0;
+	
+	// Where and when the last two steps started
+	struct Step {
+		uint16_t pc = 0;
+		uint64_t start = 0;
+	} recent[2];
+	
+	// Run-ahead
+	std::vector<uint8_t> aheadState;
+	std::vector<uint32_t> aheadPixels;
+};
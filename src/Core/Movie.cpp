@@ -0,0 +1,217 @@
+#include "Movie.h"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include "GameBoy.h"
+
+static const char MOVIE_MAGIC[4] = { 'G', 'B', 'M', 'V' };
+static const uint16_t MOVIE_VERSION = 2;
+
+struct MovieHeader {
+	char magic[4];
+	uint16_t version;
+	uint8_t backend;
+	uint8_t reserved;
+	
+	uint64_t romHash;
+	uint32_t frames;
+	uint32_t stateSize;
+	
+	uint64_t endHash;
+};
+
+void Movie::record(GameBoy& gb) {
+	gb.saveState(state);
+	
+	complete = 0;
+	finalHash = hash(state);
+	
+	romHash = hash(gb.mbc.romData().data(), gb.mbc.romData().size());
+	backend = static_cast<uint8_t>(gb.getBackend());
+	
+	inputs.clear();
+	frame = 0;
+	recording = true;
+}
+
+void Movie::recordFrame(GameBoy& gb, uint8_t input) {
+	// Same as 'playFrame', minus running it, every frame so far has run all the way
+	gb.saveState(scratch);
+	
+	complete = inputs.size();
+	finalHash = hash(scratch);
+	
+	gb.joypad.setState(input);
+	
+	inputs.push_back(input);
+	frame++;
+}
+
+bool Movie::start(GameBoy& gb) {
+	if(hash(gb.mbc.romData().data(), gb.mbc.romData().size()) != romHash) {
+		std::cerr << "[Movie] Recorded with a different ROM\n";
+		return false;
+	}
+	
+	if(!gb.setBackend(static_cast<Backend>(backend)))
+		std::cerr << "[Movie] Recorded on a different backend, this might not play back the same\n";
+	
+	if(!gb.loadState(state))
+		return false;
+	
+	frame = 0;
+	recording = false;
+	
+	return true;
+}
+
+bool Movie::playFrame(GameBoy& gb) {
+	if(frame >= inputs.size())
+		return false;
+	
+	gb.settle();
+	gb.joypad.setState(inputs[frame++]);
+	gb.runFrame();
+	
+	return true;
+}
+
+bool Movie::save(const std::string& path) const {
+	std::ofstream stream(path, std::ios::binary);
+	
+	if(!stream) {
+		std::cerr << "[Movie] Couldn't write " << path << "\n";
+		return false;
+	}
+	
+	MovieHeader header = {};
+	std::memcpy(header.magic, MOVIE_MAGIC, sizeof(MOVIE_MAGIC));
+	header.version = MOVIE_VERSION;
+	header.backend = backend;
+	header.romHash = romHash;
+	header.frames = static_cast<uint32_t>(frames());
+	header.stateSize = static_cast<uint32_t>(state.size());
+	header.endHash = finalHash;
+	
+	std::vector<uint8_t> data(sizeof(header));
+	std::memcpy(data.data(), &header, sizeof(header));
+	data.insert(data.end(), state.begin(), state.end());
+	
+	// Input hardly ever changes, so runs of the same state
+	const size_t count = frames();
+	
+	for(size_t i = 0; i < count;) {
+		size_t run = 1;
+		
+		while(i + run < count && inputs[i + run] == inputs[i])
+			run++;
+		
+		data.push_back(inputs[i]);
+		
+		for(size_t count = run; ; count >>= 7) {
+			data.push_back(static_cast<uint8_t>((count & 0x7F) | (count >= 0x80 ? 0x80 : 0)));
+			
+			if(count < 0x80)
+				break;
+		}
+		
+		i += run;
+	}
+	
+	stream.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+	
+	return static_cast<bool>(stream);
+}
+
+bool Movie::load(const std::string& path) {
+	std::ifstream stream(path, std::ios::binary);
+	
+	if(!stream) {
+		std::cerr << "[Movie] Couldn't find " << path << "\n";
+		return false;
+	}
+	
+	std::vector<uint8_t> data((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+	
+	MovieHeader header = {};
+	
+	if(data.size() < sizeof(header)) {
+		std::cerr << "[Movie] " << path << " is too small\n";
+		return false;
+	}
+	
+	std::memcpy(&header, data.data(), sizeof(header));
+	
+	if(std::memcmp(header.magic, MOVIE_MAGIC, sizeof(MOVIE_MAGIC)) != 0 || header.version != MOVIE_VERSION) {
+		std::cerr << "[Movie] " << path << " isn't a movie, or from a different version\n";
+		return false;
+	}
+	
+	if(header.stateSize > data.size() - sizeof(header)) {
+		std::cerr << "[Movie] " << path << " is cut off\n";
+		return false;
+	}
+	
+	auto it = data.begin() + sizeof(header);
+	std::vector<uint8_t> newState(it, it + header.stateSize);
+	it += header.stateSize;
+	
+	std::vector<uint8_t> newInputs;
+	newInputs.reserve(header.frames);
+	
+	while(it != data.end()) {
+		uint8_t input = *it++;
+		size_t run = 0;
+		
+		for(int shift = 0; ; shift += 7) {
+			if(it == data.end() || shift > 28) {
+				std::cerr << "[Movie] " << path << " is corrupted\n";
+				return false;
+			}
+			
+			uint8_t byte = *it++;
+			run |= static_cast<size_t>(byte & 0x7F) << shift;
+			
+			if((byte & 0x80) == 0)
+				break;
+		}
+		
+		if(newInputs.size() + run > header.frames) {
+			std::cerr << "[Movie] " << path << " is corrupted\n";
+			return false;
+		}
+		
+		newInputs.insert(newInputs.end(), run, input);
+	}
+	
+	if(newInputs.size() != header.frames) {
+		std::cerr << "[Movie] " << path << " is cut off\n";
+		return false;
+	}
+	
+	state = std::move(newState);
+	inputs = std::move(newInputs);
+	romHash = header.romHash;
+	backend = header.backend;
+	
+	complete = inputs.size();
+	finalHash = header.endHash;
+	
+	frame = 0;
+	recording = false;
+	
+	return true;
+}
+
+uint64_t Movie::hash(const uint8_t* data, size_t size) {
+	uint64_t hash = 0xCBF29CE484222325;
+	
+	for(size_t i = 0; i < size; i++) {
+		hash ^= data[i];
+		hash *= 0x100000001B3;
+	}
+	
+	return hash;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class GameBoy;
+
+/**
+ * Input movies, the joypad state for every frame,
+ * plus the save state it all started from.
+ *
+ * Input is only ever set at the start of a frame (see 'GameBoy::settle'),
+ * both while recording and replaying, so a replay runs exactly the same,
+ * on any machine, as long as it's on the same backend.
+ *
+ * The hash of the state at the end is kept too, so a replay can tell
+ * whether it really ended up in the same place. The frame that was
+ * still running when recording stopped is dropped, it has no end to check.
+ *
+ * File layout;
+ *   Header ("GBMV", version, backend, ROM hash, frames, state size, end state hash)
+ *   Save state
+ *   Input, as runs of [joypad state][varint count]
+ */
+
+class Movie {
+public:
+	// Starts a new movie from wherever 'gb' is right now
+	void record(GameBoy& gb);
+	
+	// Call at the start of every frame while recording, before it runs
+	void recordFrame(GameBoy& gb, uint8_t input);
+	
+	/**
+	 * Puts 'gb' back at the start of the movie.
+	 * Fails if it's for a different ROM.
+	 */
+	bool start(GameBoy& gb);
+	
+	// Runs the next frame, false once the movie is over
+	bool playFrame(GameBoy& gb);
+	
+	bool save(const std::string& path) const;
+	bool load(const std::string& path);
+	
+	size_t frames() const { return recording ? complete : inputs.size(); }
+	size_t position() const { return frame; }
+	
+	bool isRecording() const { return recording; }
+	
+	// State hash after the last frame, what a replay has to match
+	uint64_t endHash() const { return finalHash; }
+	
+	// FNV-1a, for the ROM, or to compare states
+	static uint64_t hash(const uint8_t* data, size_t size);
+	static uint64_t hash(const std::vector<uint8_t>& data) { return hash(data.data(), data.size()); }
+
+private:
+	std::vector<uint8_t> state;
+	std::vector<uint8_t> inputs;
+	
+	uint64_t romHash = 0;
+	uint8_t backend = 0;
+	
+	// Frames that ran all the way through, and where they ended up
+	size_t complete = 0;
+	uint64_t finalHash = 0;
+	std::vector<uint8_t> scratch;
+	
+	size_t frame = 0;
+	bool recording = false;
+};
@@ -0,0 +1,209 @@
+#include "Rewind.h"
+
+#include <chrono>
+#include <cstring>
+
+#include "GameBoy.h"
+
+// Equal bytes it takes to end a literal run, shorter ones aren't worth a new header
+static const size_t MIN_ZEROS = 8;
+
+static void writeVarint(std::vector<uint8_t>& out, size_t value) {
+	while(value >= 0x80) {
+		out.push_back(static_cast<uint8_t>(value | 0x80));
+		value >>= 7;
+	}
+	
+	out.push_back(static_cast<uint8_t>(value));
+}
+
+static bool readVarint(const std::vector<uint8_t>& in, size_t& pos, size_t& value) {
+	value = 0;
+	
+	for(int shift = 0; shift < 64; shift += 7) {
+		if(pos >= in.size())
+			return false;
+		
+		uint8_t byte = in[pos++];
+		value |= static_cast<size_t>(byte & 0x7F) << shift;
+		
+		if((byte & 0x80) == 0)
+			return true;
+	}
+	
+	return false;
+}
+
+Rewind::Rewind(GameBoy& gb, uint32_t interval, size_t capacity)
+	: interval(interval), capacity(capacity), gb(gb) {
+	
+}
+
+void Rewind::frame() {
+	atCurrent = false;
+	
+	if(++frames < interval)
+		return;
+	
+	frames = 0;
+	capture();
+}
+
+void Rewind::capture() {
+	auto start = std::chrono::steady_clock::now();
+	
+	gb.saveState(scratch);
+	
+	if(!current.empty()) {
+		Delta delta;
+		
+		if(scratch.size() == current.size()) {
+			encode(scratch, current, encoded);
+			delta.data.assign(encoded.begin(), encoded.end());
+		} else {
+			delta.data = current;
+			delta.full = true;
+		}
+		
+		deltaBytes += delta.data.size();
+		deltas.push_back(std::move(delta));
+	}
+	
+	current.swap(scratch);
+	atCurrent = true;
+	
+	// Oldest history goes first
+	while(!deltas.empty() && memoryUsed() > capacity) {
+		deltaBytes -= deltas.front().data.size();
+		deltas.pop_front();
+	}
+	
+	lastCaptureMicros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+
+bool Rewind::rewind() {
+	if(current.empty())
+		return false;
+	
+	// Went past the newest snapshot, go back to it first
+	if(!atCurrent) {
+		atCurrent = true;
+		frames = 0;
+		
+		return gb.loadState(current, true);
+	}
+	
+	if(deltas.empty())
+		return false;
+	
+	Delta& delta = deltas.back();
+	deltaBytes -= delta.data.size();
+	
+	if(delta.full) {
+		current.swap(delta.data);
+	} else if(!apply(delta.data, current)) {
+		// Shouldn't happen, but nothing older can be trusted anymore
+		clear();
+		
+		return false;
+	}
+	
+	deltas.pop_back();
+	
+	frames = 0;
+	
+	return gb.loadState(current, true);
+}
+
+void Rewind::clear() {
+	current.clear();
+	deltas.clear();
+	deltaBytes = 0;
+	
+	frames = 0;
+	atCurrent = false;
+}
+
+size_t Rewind::snapshots() const {
+	return current.empty() ? 0 : deltas.size() + 1;
+}
+
+double Rewind::seconds() const {
+	return static_cast<double>(snapshots()) * interval / 60.0;
+}
+
+/**
+ * 'a' XOR 'b' as runs of; [equal bytes][differing bytes][the XOR'ed bytes].
+ * Both lengths are varints.
+ */
+void Rewind::encode(const std::vector<uint8_t>& a, const std::vector<uint8_t>& b, std::vector<uint8_t>& out) {
+	const size_t size = a.size();
+	const uint8_t* x = a.data();
+	const uint8_t* y = b.data();
+	
+	out.clear();
+	
+	size_t i = 0;
+	
+	while(i < size) {
+		// Equal bytes, 8 at a time where possible
+		const size_t zeroStart = i;
+		
+		while(i + 8 <= size && std::memcmp(x + i, y + i, 8) == 0)
+			i += 8;
+		
+		while(i < size && x[i] == y[i])
+			i++;
+		
+		// Differing bytes, up until there's enough equal ones in a row
+		const size_t literalStart = i;
+		
+		while(i < size) {
+			if(x[i] != y[i]) {
+				i++;
+				continue;
+			}
+			
+			size_t j = i;
+			
+			while(j < size && x[j] == y[j] && j - i < MIN_ZEROS)
+				j++;
+			
+			if(j - i >= MIN_ZEROS || j == size)
+				break;
+			
+			i = j;
+		}
+		
+		writeVarint(out, literalStart - zeroStart);
+		writeVarint(out, i - literalStart);
+		
+		for(size_t k = literalStart; k < i; k++)
+			out.push_back(x[k] ^ y[k]);
+	}
+}
+
+bool Rewind::apply(const std::vector<uint8_t>& delta, std::vector<uint8_t>& state) {
+	size_t pos = 0;
+	size_t i = 0;
+	
+	while(pos < delta.size()) {
+		size_t zeros = 0, literals = 0;
+		
+		if(!readVarint(delta, pos, zeros) || !readVarint(delta, pos, literals))
+			return false;
+		
+		i += zeros;
+		
+		if(i > state.size() || literals > state.size() - i || literals > delta.size() - pos)
+			return false;
+		
+		for(size_t k = 0; k < literals; k++)
+			state[i + k] ^= delta[pos + k];
+		
+		i += literals;
+		pos += literals;
+	}
+	
+	return true;
+}
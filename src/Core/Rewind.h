@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+class GameBoy;
+
+/**
+ * Keeps the last few minutes of save states around.
+ *
+ * Only the newest state is kept as is, every older one is stored
+ * as the XOR against the one after it, run-length encoded.
+ * Most of the machine doesn't change between two snapshots,
+ * so those are mostly zeros and end up tiny.
+ *
+ * XOR works both ways, so stepping back is just applying
+ * the newest delta to the newest state, and running out of space
+ * is just throwing the oldest delta away.
+ */
+
+class Rewind {
+public:
+	/**
+	 * 'interval' - Frames between two snapshots
+	 * 'capacity' - Bytes the history may use, the oldest snapshots go first
+	 */
+	Rewind(GameBoy& gb, uint32_t interval = 4, size_t capacity = 8 * 1024 * 1024);
+	
+	// Call once per emulated frame, takes a snapshot every 'interval' frames
+	void frame();
+	
+	// Snapshots right away
+	void capture();
+	
+	/**
+	 * Goes back one snapshot (or to the newest one,
+	 * if frames ran since it was taken).
+	 * Returns false once there's no history left.
+	 */
+	bool rewind();
+	
+	void clear();
+	
+	// Snapshots that can be gone back to
+	size_t snapshots() const;
+	
+	// Seconds of history, at 60 frames a second
+	double seconds() const;
+	
+	// Bytes used, including the newest full state
+	size_t memoryUsed() const { return deltaBytes + current.size(); }
+
+public:
+	uint32_t interval;
+	size_t capacity;
+	
+	// How long the last 'capture' took (save + encode)
+	double lastCaptureMicros = 0;
+
+private:
+	struct Delta {
+		/**
+		 * XOR of two states of the same size, run-length encoded.
+		 * If the size changed in between, the older state as is.
+		 */
+		std::vector<uint8_t> data;
+		bool full = false;
+	};
+	
+	static void encode(const std::vector<uint8_t>& a, const std::vector<uint8_t>& b, std::vector<uint8_t>& out);
+	static bool apply(const std::vector<uint8_t>& delta, std::vector<uint8_t>& state);
+
+private:
+	GameBoy& gb;
+	
+	uint32_t frames = 0;
+	
+	// Newest snapshot, and whether the machine still is at it
+	std::vector<uint8_t> current;
+	bool atCurrent = false;
+	
+	// Oldest first
+	std::deque<Delta> deltas;
+	size_t deltaBytes = 0;
+	
+	std::vector<uint8_t> scratch;
+	std::vector<uint8_t> encoded;
+};
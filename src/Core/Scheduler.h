@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+ * Keeps track of when the next thing happens,
+ * that the CPU (or the screen) could notice.
+ *
+ * Everything is in T-Cycles since power on ('cycles'),
+ * components are only ticked once the CPU reaches the earliest deadline,
+ * or right before it touches IO; see GameBoy::flush.
+ *
+ * Every source only has one deadline at a time,
+ * so it's a slot each, with the earliest one cached.
+ */
+
+class Scheduler {
+public:
+	enum Event : uint8_t {
+		// Mode/LY change; draws a line and can raise STAT/VBlank
+		PPUMode,
+		
+		// TIMA overflow
+		TimerOverflow,
+		
+		// DIV-APU step, so audio never falls too far behind
+		FrameSequencer,
+		
+		// OAM DMA/HDMA (or a speed switch), those still tick every instruction
+		DMA,
+		
+		Count
+	};
+	
+	static constexpr uint64_t NEVER = UINT64_MAX;
+	
+	void schedule(Event event, uint64_t cycle) {
+		deadlines[event] = cycle;
+		
+		earliest = NEVER;
+		
+		for(uint64_t deadline : deadlines) {
+			if(deadline < earliest)
+				earliest = deadline;
+		}
+	}
+	
+	void cancel(Event event) {
+		schedule(event, NEVER);
+	}
+	
+	uint64_t next() const { return earliest; }
+	uint64_t deadline(Event event) const { return deadlines[event]; }
+
+public:
+	// Cycles everything has been ticked by
+	uint64_t cycles = 0;
+	
+	// How many times everything got ticked
+	uint64_t flushes = 0;
+
+private:
+	uint64_t deadlines[Count] = { NEVER, NEVER, NEVER, NEVER };
+	uint64_t earliest = NEVER;
+};
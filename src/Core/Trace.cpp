@@ -0,0 +1,463 @@
+#include "Trace.h"
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+#include "GameBoy.h"
+
+static const char TRACE_MAGIC[4] = { 'G', 'B', 'T', 'R' };
+static const uint16_t TRACE_VERSION = 1;
+
+// Header flags
+static const uint16_t FLAG_WRITES = 1 << 0;
+
+// Record mask, bits 0-7 are the registers (A F B C D E H L)
+static const uint16_t MASK_SP    = 1 << 8;
+static const uint16_t MASK_PC    = 1 << 9;
+static const uint16_t MASK_BANK  = 1 << 10;
+static const uint16_t MASK_IME   = 1 << 11;
+static const uint16_t MASK_LY    = 1 << 12;
+static const uint16_t MASK_PCMEM = 1 << 13;
+static const uint16_t MASK_WRITE = 1 << 15;
+
+struct TraceHeader {
+	char magic[4];
+	uint16_t version;
+	uint16_t flags;
+};
+
+// Where the next instruction should be, if nothing jumped
+static uint16_t expectedPC(const TraceRecord& last) {
+	return static_cast<uint16_t>(last.PC + DecodeCache::lengths[last.pcmem[0]]);
+}
+
+static bool samePcmem(const TraceContext& context, const TraceRecord& record) {
+	if(record.PC <= 0xFFFC)
+		return std::memcmp(context.shadow + record.PC, record.pcmem, 4) == 0;
+	
+	for(uint16_t i = 0; i < 4; i++) {
+		if(context.shadow[static_cast<uint16_t>(record.PC + i)] != record.pcmem[i])
+			return false;
+	}
+	
+	return true;
+}
+
+static void updateShadow(TraceContext& context, const TraceRecord& record) {
+	for(uint16_t i = 0; i < 4; i++) {
+		context.shadow[static_cast<uint16_t>(record.PC + i)] = record.pcmem[i];
+	}
+}
+
+static uint8_t* writeVarint(uint8_t* out, uint64_t value) {
+	while(value >= 0x80) {
+		*out++ = static_cast<uint8_t>(value | 0x80);
+		value >>= 7;
+	}
+	
+	*out++ = static_cast<uint8_t>(value);
+	
+	return out;
+}
+
+static uint8_t* write16(uint8_t* out, uint16_t value) {
+	out[0] = static_cast<uint8_t>(value);
+	out[1] = static_cast<uint8_t>(value >> 8);
+	
+	return out + 2;
+}
+
+/**
+ * Writes 'value' at 'out' either way, but only keeps it (and sets 'bit')
+ * if it changed, that's cheaper than mispredicting on random code.
+ */
+template <typename T>
+static void writeIf(uint8_t*& out, uint16_t& mask, uint16_t bit, bool changed, T value) {
+	std::memcpy(out, &value, sizeof(T));
+	
+	out += changed * sizeof(T);
+	mask |= changed ? bit : 0;
+}
+
+/**
+ * Tracer
+ */
+
+Tracer::~Tracer() {
+	stop();
+}
+
+bool Tracer::start(GameBoy& gb, const std::string& path, bool writes) {
+	stop();
+	
+	if(gb.getBackend() == Backend::Recompiler) {
+		std::cerr << "[Trace] The recompiler can't be traced, switching to the interpreter\n";
+		gb.setBackend(Backend::Interpreter);
+	}
+	
+	file = fopen(path.c_str(), "wb");
+	
+	if(!file) {
+		std::cerr << "[Trace] Couldn't write " << path << "\n";
+		return false;
+	}
+	
+	TraceHeader header = {};
+	std::memcpy(header.magic, TRACE_MAGIC, sizeof(TRACE_MAGIC));
+	header.version = TRACE_VERSION;
+	header.flags = writes ? FLAG_WRITES : 0;
+	fwrite(&header, sizeof(header), 1, file);
+	
+	if(!chunks) {
+		chunks = std::make_unique<Capture[]>(CHUNK_CAPTURES * CHUNKS);
+		encoded = std::make_unique<uint8_t[]>(CHUNK_CAPTURES * MAX_RECORD);
+	}
+	
+	context = TraceContext();
+	
+	head = 0;
+	tail = 0;
+	stopping = false;
+	
+	out = chunks.get();
+	end = out + CHUNK_CAPTURES;
+	
+	recordCount = 0;
+	byteCount = sizeof(header);
+	
+	writer = std::thread(&Tracer::writerLoop, this);
+	
+	this->gb = &gb;
+	gb.cpu.tracer = this;
+	
+	// Whoever hooked writes before still sees them, and gets the hook back on 'stop'
+	if(writes) {
+		previousHook = std::move(gb.mmu.writeHook);
+		hooked = true;
+		
+		gb.mmu.writeHook = [this](uint16_t address, uint8_t value) {
+			if(previousHook)
+				previousHook(address, value);
+			
+			write(address, value);
+		};
+		gb.mmu.updatePages();
+	}
+	
+	return true;
+}
+
+void Tracer::stop() {
+	if(!gb)
+		return;
+	
+	gb->cpu.tracer = nullptr;
+	
+	// Only if it's the tracer's own
+	if(hooked) {
+		gb->mmu.writeHook = std::move(previousHook);
+		gb->mmu.updatePages();
+		
+		previousHook = nullptr;
+		hooked = false;
+	}
+	
+	gb = nullptr;
+	
+	// Whatever's in the current chunk, then wait for the writer to catch up
+	publish();
+	
+	stopping = true;
+	writer.join();
+	
+	fclose(file);
+	file = nullptr;
+}
+
+void Tracer::instruction(const CPU& cpu) {
+	Capture& capture = next();
+	capture.write = false;
+	
+	TraceRecord& record = capture.record;
+	record.cycle = gb->cycles();
+	
+	record.regs[0] = cpu.AF.A;
+	record.regs[1] = cpu.AF.F;
+	record.regs[2] = cpu.BC.B;
+	record.regs[3] = cpu.BC.C;
+	record.regs[4] = cpu.DE.D;
+	record.regs[5] = cpu.DE.E;
+	record.regs[6] = cpu.HL.H;
+	record.regs[7] = cpu.HL.L;
+	
+	record.SP = cpu.SP;
+	record.PC = cpu.PC;
+	record.IME = cpu.interruptHandler.IME;
+	record.LY = cpu.mmu.lcdc.LY;
+	
+	// Same as 'CPU::profileLocation', without a call per instruction
+	if(cpu.PC < 0x8000)
+		record.bank = static_cast<uint16_t>(cpu.mmu.romBankOffset[cpu.PC >> 14] >> 14);
+	else if(cpu.PC >= 0xD000 && cpu.PC < 0xE000)
+		record.bank = cpu.mmu.getWramBank();
+	else
+		record.bank = 0;
+	
+	// Straight out of the page, unless it's split over two
+	const uint8_t* page = cpu.mmu.readPages[cpu.PC >> 8];
+	
+	if(page && (cpu.PC & 0xFF) <= 0xFC) {
+		std::memcpy(record.pcmem, page + (cpu.PC & 0xFF), 4);
+	} else {
+		for(uint16_t i = 0; i < 4; i++) {
+			record.pcmem[i] = cpu.mmu.peek(static_cast<uint16_t>(cpu.PC + i));
+		}
+	}
+}
+
+void Tracer::write(uint16_t address, uint8_t value) {
+	Capture& capture = next();
+	capture.write = true;
+	capture.record.PC = address;
+	capture.record.regs[0] = value;
+}
+
+uint8_t* Tracer::encode(const Capture& capture, uint8_t* p) {
+	if(capture.write) {
+		p = write16(p, MASK_WRITE);
+		p = write16(p, capture.record.PC);
+		*p++ = capture.record.regs[0];
+		
+		return p;
+	}
+	
+	const TraceRecord& record = capture.record;
+	const TraceRecord& last = context.last;
+	uint16_t mask = 0;
+	
+	// Mask goes in front, once it's known
+	uint8_t* start = p;
+	p = writeVarint(p + 2, record.cycle - last.cycle);
+	
+	for(int i = 0; i < 8; i++) {
+		writeIf(p, mask, static_cast<uint16_t>(1 << i), record.regs[i] != last.regs[i], record.regs[i]);
+	}
+	
+	writeIf(p, mask, MASK_SP, record.SP != last.SP, record.SP);
+	writeIf(p, mask, MASK_PC, record.PC != expectedPC(last), record.PC);
+	writeIf(p, mask, MASK_BANK, record.bank != last.bank, record.bank);
+	writeIf(p, mask, MASK_IME, record.IME != last.IME, record.IME);
+	writeIf(p, mask, MASK_LY, record.LY != last.LY, record.LY);
+	
+	if(!samePcmem(context, record)) {
+		mask |= MASK_PCMEM;
+		std::memcpy(p, record.pcmem, 4);
+		p += 4;
+		
+		updateShadow(context, record);
+	}
+	
+	write16(start, mask);
+	
+	context.last = record;
+	recordCount.fetch_add(1, std::memory_order_relaxed);
+	
+	return p;
+}
+
+void Tracer::publish() {
+	const uint64_t current = head.load(std::memory_order_relaxed);
+	Capture* start = chunks.get() + (current % CHUNKS) * CHUNK_CAPTURES;
+	
+	sizes[current % CHUNKS] = static_cast<size_t>(out - start);
+	
+	head.store(current + 1, std::memory_order_release);
+	
+	// Ring's full, the writer can't keep up
+	while(current + 1 - tail.load(std::memory_order_acquire) >= CHUNKS) {
+		std::this_thread::yield();
+	}
+	
+	out = chunks.get() + ((current + 1) % CHUNKS) * CHUNK_CAPTURES;
+	end = out + CHUNK_CAPTURES;
+}
+
+void Tracer::writerLoop() {
+	while(true) {
+		const uint64_t current = tail.load(std::memory_order_relaxed);
+		
+		if(current < head.load(std::memory_order_acquire)) {
+			const Capture* captures = chunks.get() + (current % CHUNKS) * CHUNK_CAPTURES;
+			uint8_t* p = encoded.get();
+			
+			for(size_t i = 0; i < sizes[current % CHUNKS]; i++) {
+				p = encode(captures[i], p);
+			}
+			
+			const size_t size = static_cast<size_t>(p - encoded.get());
+			fwrite(encoded.get(), 1, size, file);
+			byteCount.fetch_add(size, std::memory_order_relaxed);
+			
+			tail.store(current + 1, std::memory_order_release);
+			
+			continue;
+		}
+		
+		// Everything before 'stopping' was published, so this is the end
+		if(stopping.load(std::memory_order_acquire)) {
+			if(current == head.load(std::memory_order_acquire))
+				break;
+			
+			continue;
+		}
+		
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+}
+
+/**
+ * TraceReader
+ */
+
+bool TraceReader::open(const std::string& path) {
+	file.reset(fopen(path.c_str(), "rb"));
+	
+	if(!file) {
+		std::cerr << "[Trace] Couldn't find " << path << "\n";
+		return false;
+	}
+	
+	TraceHeader header = {};
+	
+	if(fread(&header, sizeof(header), 1, file.get()) != 1
+		|| std::memcmp(header.magic, TRACE_MAGIC, sizeof(TRACE_MAGIC)) != 0 || header.version != TRACE_VERSION) {
+		std::cerr << "[Trace] " << path << " isn't a trace, or from a different version\n";
+		
+		file.reset();
+		return false;
+	}
+	
+	writes = (header.flags & FLAG_WRITES) != 0;
+	
+	buffer.clear();
+	position = 0;
+	context = TraceContext();
+	
+	return true;
+}
+
+bool TraceReader::fill() {
+	static const size_t READ_SIZE = 1024 * 1024;
+	
+	// A whole record is never bigger than this
+	if(buffer.size() - position >= 64)
+		return true;
+	
+	buffer.erase(buffer.begin(), buffer.begin() + static_cast<std::ptrdiff_t>(position));
+	position = 0;
+	
+	const size_t size = buffer.size();
+	buffer.resize(size + READ_SIZE);
+	buffer.resize(size + fread(buffer.data() + size, 1, READ_SIZE, file.get()));
+	
+	return !buffer.empty();
+}
+
+bool TraceReader::next(TraceRecord& record, std::vector<uint32_t>& writes) {
+	writes.clear();
+	
+	if(!file)
+		return false;
+	
+	while(fill()) {
+		const uint8_t* p = buffer.data() + position;
+		const uint8_t* end = buffer.data() + buffer.size();
+		
+		auto read8 = [&](uint8_t& value) {
+			if(p >= end) return false;
+			
+			value = *p++;
+			return true;
+		};
+		
+		auto read16 = [&](uint16_t& value) {
+			uint8_t low, high;
+			
+			if(!read8(low) || !read8(high)) return false;
+			
+			value = static_cast<uint16_t>(high << 8 | low);
+			return true;
+		};
+		
+		uint16_t mask;
+		
+		if(!read16(mask))
+			return false;
+		
+		if(mask & MASK_WRITE) {
+			uint16_t address;
+			uint8_t value;
+			
+			if(!read16(address) || !read8(value))
+				return false;
+			
+			writes.push_back(static_cast<uint32_t>(address) << 8 | value);
+			position = static_cast<size_t>(p - buffer.data());
+			
+			continue;
+		}
+		
+		const TraceRecord& last = context.last;
+		record = last;
+		
+		uint64_t delta = 0;
+		
+		for(int shift = 0; ; shift += 7) {
+			uint8_t byte;
+			
+			if(shift > 63 || !read8(byte))
+				return false;
+			
+			delta |= static_cast<uint64_t>(byte & 0x7F) << shift;
+			
+			if((byte & 0x80) == 0)
+				break;
+		}
+		
+		record.cycle = last.cycle + delta;
+		
+		for(int i = 0; i < 8; i++) {
+			if((mask & (1 << i)) && !read8(record.regs[i]))
+				return false;
+		}
+		
+		record.PC = expectedPC(last);
+		
+		if((mask & MASK_SP) && !read16(record.SP)) return false;
+		if((mask & MASK_PC) && !read16(record.PC)) return false;
+		if((mask & MASK_BANK) && !read16(record.bank)) return false;
+		if((mask & MASK_IME) && !read8(record.IME)) return false;
+		if((mask & MASK_LY) && !read8(record.LY)) return false;
+		
+		if(mask & MASK_PCMEM) {
+			for(int i = 0; i < 4; i++) {
+				if(!read8(record.pcmem[i]))
+					return false;
+			}
+			
+			updateShadow(context, record);
+		} else {
+			for(uint16_t i = 0; i < 4; i++) {
+				record.pcmem[i] = context.shadow[static_cast<uint16_t>(record.PC + i)];
+			}
+		}
+		
+		position = static_cast<size_t>(p - buffer.data());
+		context.last = record;
+		
+		return true;
+	}
+	
+	return false;
+}
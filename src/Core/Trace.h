@@ -0,0 +1,179 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+class CPU;
+class GameBoy;
+
+/**
+ * Binary execution traces, one record before every instruction,
+ * plus (optionally) every byte the CPU wrote in between.
+ *
+ * Records are delta encoded against the one before; only what changed
+ * is stored, PC only if it isn't right after the last instruction,
+ * and the 4 bytes at PC only if they differ from the last time
+ * that address was traced. Most records end up 3-6 bytes.
+ *
+ * The emulator only copies a fixed size snapshot per instruction (or write)
+ * into chunks, full chunks go through a lock-free ring to a thread
+ * that does the encoding and writes them out.
+ *
+ * Only the interpreter is traced, the recompiler never calls 'CPU::cycle'.
+ *
+ * File layout;
+ *   Header ("GBTR", version, flags)
+ *   Records; [u16 mask][varint cycles since the last one][changed fields],
+ *   or with MASK_WRITE set; [u16 mask][u16 address][u8 value]
+ */
+
+struct TraceRecord {
+	// T-Cycle the instruction started on
+	uint64_t cycle = 0;
+	
+	// A F B C D E H L
+	uint8_t regs[8] = {};
+	
+	uint16_t SP = 0;
+	uint16_t PC = 0;
+	
+	// ROM bank for 0x0000-0x7FFF, WRAM bank for 0xD000-0xDFFF, 0 otherwise
+	uint16_t bank = 0;
+	
+	uint8_t IME = 0;
+	uint8_t LY = 0;
+	
+	// The instruction's bytes
+	uint8_t pcmem[4] = {};
+};
+
+/**
+ * What both the writer and the reader keep track of,
+ * so they predict the exact same thing.
+ */
+struct TraceContext {
+	TraceRecord last;
+	
+	// Last bytes seen at every address, through 'pcmem'
+	uint8_t shadow[0x10000] = {};
+};
+
+class Tracer {
+public:
+	Tracer() = default;
+	~Tracer();
+	
+	Tracer(const Tracer&) = delete;
+	Tracer& operator=(const Tracer&) = delete;
+	
+	/**
+	 * Starts tracing 'gb' into 'path',
+	 * 'writes' also records every byte the CPU writes.
+	 */
+	bool start(GameBoy& gb, const std::string& path, bool writes = false);
+	
+	// Writes out everything that's left, and detaches from the GameBoy
+	void stop();
+	
+	bool isRunning() const { return gb != nullptr; }
+	
+	// Called by the CPU, right before it fetches an instruction
+	void instruction(const CPU& cpu);
+	
+	// Called by the MMU, for every write the CPU makes
+	void write(uint16_t address, uint8_t value);
+	
+	// Written out so far, counted by the writer
+	uint64_t records() const { return recordCount; }
+	uint64_t bytes() const { return byteCount; }
+
+private:
+	/**
+	 * An instruction as it was captured,
+	 * or a write, with the address in 'record.PC' and the value in 'record.regs[0]'.
+	 */
+	struct Capture {
+		TraceRecord record;
+		bool write;
+	};
+	
+	// Makes sure there's room for one more
+	Capture& next() {
+		if(out == end)
+			publish();
+		
+		return *out++;
+	}
+	
+	void publish();
+	void writerLoop();
+	
+	// Writer side, delta encodes one capture into 'p'
+	uint8_t* encode(const Capture& capture, uint8_t* p);
+
+private:
+	static constexpr size_t CHUNK_CAPTURES = 8192;
+	static constexpr size_t CHUNKS = 16;
+	static constexpr size_t MAX_RECORD = 64;
+	
+	GameBoy* gb = nullptr;
+	FILE* file = nullptr;
+	
+	// Set while the tracer's write hook is installed, chained to whatever was there before
+	bool hooked = false;
+	std::function<void(uint16_t, uint8_t)> previousHook;
+	
+	// Only the writer touches these
+	TraceContext context;
+	std::unique_ptr<uint8_t[]> encoded;
+	
+	/**
+	 * Single producer (the emulator), single consumer (the writer).
+	 * Chunks [tail, head) are full and waiting to be written,
+	 * the emulator fills chunk 'head'.
+	 */
+	std::unique_ptr<Capture[]> chunks;
+	size_t sizes[CHUNKS] = {};
+	std::atomic<uint64_t> head { 0 };
+	std::atomic<uint64_t> tail { 0 };
+	std::atomic<bool> stopping { false };
+	
+	Capture* out = nullptr;
+	Capture* end = nullptr;
+	
+	std::thread writer;
+	
+	std::atomic<uint64_t> recordCount { 0 };
+	std::atomic<uint64_t> byteCount { 0 };
+};
+
+class TraceReader {
+public:
+	bool open(const std::string& path);
+	
+	/**
+	 * Next instruction, with the writes the one before it made in 'writes'
+	 * (address << 8 | value). False at the end, or if the trace is broken.
+	 */
+	bool next(TraceRecord& record, std::vector<uint32_t>& writes);
+	
+	bool hasWrites() const { return writes; }
+
+private:
+	bool fill();
+
+private:
+	std::unique_ptr<FILE, int (*)(FILE*)> file { nullptr, fclose };
+	
+	std::vector<uint8_t> buffer;
+	size_t position = 0;
+	
+	TraceContext context;
+	bool writes = false;
+};
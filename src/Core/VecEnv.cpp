@@ -0,0 +1,217 @@
+#include "VecEnv.h"
+#include "VecEnvC.h"
+
+#include <algorithm>
+
+VecEnv::VecEnv(RomHandle rom, size_t count, uint32_t threads, Backend backend, ScreenFormat format,
+			   uint32_t seed)
+	: format(format) {
+	if(count == 0)
+		count = 1;
+	
+	instances.reserve(count);
+	
+	for(size_t i = 0; i < count; i++) {
+		// No boot ROM, starts at 0x100
+		auto gb = std::make_unique<GameBoy>(rom, std::vector<uint8_t>());
+		gb->setBackend(backend);
+		gb->apu.output = false;
+		
+		instances.push_back(std::move(gb));
+	}
+	
+	// Everyone starts out from the first one
+	instances[0]->wram.randomize(seed);
+	instances[0]->saveState(startState);
+	
+	screenBuffer.resize(count * SCREEN_SIZE);
+	reset();
+	
+	if(threads == 0)
+		threads = std::max(1u, std::thread::hardware_concurrency());
+	
+	threads = static_cast<uint32_t>(std::min<size_t>(threads, count));
+	
+	// The caller is one of them
+	for(uint32_t i = 1; i < threads; i++) {
+		workers.emplace_back(&VecEnv::workerLoop, this);
+	}
+}
+
+VecEnv::~VecEnv() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	
+	wake.notify_all();
+	
+	for(std::thread& worker : workers) {
+		worker.join();
+	}
+}
+
+void VecEnv::step(const uint8_t* inputs, uint32_t frames) {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		
+		this->inputs = inputs;
+		this->frames = frames;
+		
+		remaining = instances.size();
+		next = 0;
+		
+		generation++;
+	}
+	
+	wake.notify_all();
+	
+	runJob();
+	
+	std::unique_lock<std::mutex> lock(mutex);
+	done.wait(lock, [this] { return remaining == 0; });
+}
+
+void VecEnv::reset() {
+	for(size_t i = 0; i < instances.size(); i++) {
+		reset(i);
+	}
+}
+
+void VecEnv::reset(size_t index) {
+	GameBoy& gb = *instances[index];
+	
+	gb.loadState(startState, true);
+	gb.frameCycles = 0;
+	
+	observe(index);
+}
+
+void VecEnv::watch(const std::vector<uint16_t>& addresses) {
+	this->addresses = addresses;
+	ramBuffer.assign(instances.size() * addresses.size(), 0);
+	
+	for(size_t i = 0; i < instances.size(); i++) {
+		observe(i);
+	}
+}
+
+void VecEnv::runJob() {
+	for(size_t i = next++; i < instances.size(); i = next++) {
+		runInstance(i);
+		
+		if(--remaining == 0) {
+			// Lock so the caller can't miss it between checking and waiting
+			std::lock_guard<std::mutex> lock(mutex);
+			done.notify_one();
+		}
+	}
+}
+
+void VecEnv::runInstance(size_t index) {
+	GameBoy& gb = *instances[index];
+	
+	// Same as a movie, input only changes between frames
+	gb.settle();
+	gb.joypad.setState(inputs[index]);
+	
+	// Only the last frame gets looked at
+	for(uint32_t i = 0; i < frames; i++) {
+		gb.ppu.render = i + 1 == frames;
+		gb.runFrame();
+	}
+	
+	gb.ppu.render = true;
+	
+	observe(index);
+}
+
+void VecEnv::observe(size_t index) {
+	GameBoy& gb = *instances[index];
+	
+	const uint32_t* pixels = gb.ppu.pixels;
+	uint8_t* screen = screenBuffer.data() + index * SCREEN_SIZE;
+	
+	for(size_t i = 0; i < SCREEN_SIZE; i++) {
+		uint32_t r = (pixels[i] >> 16) & 0xFF;
+		uint32_t g = (pixels[i] >> 8) & 0xFF;
+		uint32_t b = pixels[i] & 0xFF;
+		
+		// BT.601 luma, in fixed point
+		uint8_t gray = static_cast<uint8_t>((r * 77 + g * 150 + b * 29) >> 8);
+		
+		screen[i] = format == ScreenFormat::Grayscale ? gray : static_cast<uint8_t>(3 - (gray >> 6));
+	}
+	
+	uint8_t* ram = ramBuffer.data() + index * addresses.size();
+	
+	for(size_t i = 0; i < addresses.size(); i++) {
+		ram[i] = gb.mmu.fetch8(addresses[i]);
+	}
+}
+
+void VecEnv::workerLoop() {
+	uint64_t seen = 0;
+	
+	while(true) {
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wake.wait(lock, [this, seen] { return stopping || generation != seen; });
+			
+			if(stopping)
+				return;
+			
+			seen = generation;
+		}
+		
+		runJob();
+	}
+}
+
+// C API
+
+struct gb_vecenv {
+	VecEnv env;
+};
+
+gb_vecenv* gb_vecenv_create(const uint8_t* rom, size_t romSize, size_t count,
+							uint32_t threads, int recompiler, int shades, uint32_t seed) {
+	// Has to at least have a header
+	if(!rom || romSize < 0x150)
+		return nullptr;
+	
+	return new gb_vecenv { VecEnv(RomImage::fromBytes(std::vector<uint8_t>(rom, rom + romSize)), count, threads,
+								  recompiler ? Backend::Recompiler : Backend::Interpreter,
+								  shades ? ScreenFormat::Shade : ScreenFormat::Grayscale, seed) };
+}
+
+void gb_vecenv_destroy(gb_vecenv* env) {
+	delete env;
+}
+
+void gb_vecenv_step(gb_vecenv* env, const uint8_t* inputs, uint32_t frames) {
+	env->env.step(inputs, frames);
+}
+
+void gb_vecenv_reset(gb_vecenv* env, ptrdiff_t index) {
+	if(index < 0)
+		env->env.reset();
+	else if(static_cast<size_t>(index) < env->env.size())
+		env->env.reset(static_cast<size_t>(index));
+}
+
+void gb_vecenv_watch(gb_vecenv* env, const uint16_t* addresses, size_t count) {
+	env->env.watch(std::vector<uint16_t>(addresses, addresses + count));
+}
+
+size_t gb_vecenv_size(const gb_vecenv* env) {
+	return env->env.size();
+}
+
+const uint8_t* gb_vecenv_screens(const gb_vecenv* env) {
+	return env->env.screens();
+}
+
+const uint8_t* gb_vecenv_ram(const gb_vecenv* env) {
+	return env->env.ram();
+}
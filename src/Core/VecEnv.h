@@ -0,0 +1,113 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "GameBoy.h"
+
+/**
+ * A batch of Game Boys running the same ROM image, for training agents.
+ *
+ * 'step' runs every one of them for a frame, each with its own joypad state,
+ * spread over a thread pool (the calling thread helps out too).
+ * Afterwards all the screens are in one N x 144 x 160 byte buffer,
+ * and the watched RAM addresses in one N x K buffer, both indexed by instance.
+ *
+ * All of them start out, and 'reset' back to, the exact same state,
+ * which only depends on the ROM and 'seed' (the power up WRAM garbage),
+ * so two runs with the same inputs see the same thing.
+ * No audio is generated, nobody would listen to it.
+ */
+
+enum class ScreenFormat {
+	// 0 (black) - 255 (white)
+	Grayscale,
+	
+	// 0 (white) - 3 (black), the DMG shades, CGB colors are binned by brightness
+	Shade
+};
+
+class VecEnv {
+public:
+	/**
+	 * 'threads' - Threads stepping instances, including the caller, 0 for one per core
+	 */
+	VecEnv(RomHandle rom, size_t count, uint32_t threads = 0,
+		   Backend backend = Backend::Interpreter, ScreenFormat format = ScreenFormat::Grayscale,
+		   uint32_t seed = 0);
+	~VecEnv();
+	
+	VecEnv(const VecEnv&) = delete;
+	VecEnv& operator=(const VecEnv&) = delete;
+	
+	/**
+	 * Runs every instance for 'frames' frames,
+	 * 'inputs' holds one joypad state per instance (see 'Joypad::setState').
+	 * Only the last frame's screen ends up in 'screens'.
+	 */
+	void step(const uint8_t* inputs, uint32_t frames = 1);
+	
+	// Everything back to the start
+	void reset();
+	
+	// Just one, for when its episode is over
+	void reset(size_t index);
+	
+	/**
+	 * Addresses read into 'ram' after every step (and reset),
+	 * anything the CPU could read, through the MMU.
+	 */
+	void watch(const std::vector<uint16_t>& addresses);
+	
+	size_t size() const { return instances.size(); }
+	uint32_t threadCount() const { return static_cast<uint32_t>(workers.size()) + 1; }
+	
+	// N x 144 x 160
+	const uint8_t* screens() const { return screenBuffer.data(); }
+	static constexpr size_t SCREEN_SIZE = PPU::SCREEN_WIDTH * PPU::SCREEN_HEIGHT;
+	
+	// N x 'watched'
+	const uint8_t* ram() const { return ramBuffer.data(); }
+	size_t watched() const { return addresses.size(); }
+	
+	GameBoy& at(size_t index) { return *instances[index]; }
+
+private:
+	// Hands out instances to the pool, until there's none left
+	void runJob();
+	
+	void runInstance(size_t index);
+	void observe(size_t index);
+	
+	void workerLoop();
+
+private:
+	std::vector<std::unique_ptr<GameBoy>> instances;
+	std::vector<uint8_t> startState;
+	
+	ScreenFormat format;
+	std::vector<uint16_t> addresses;
+	
+	std::vector<uint8_t> screenBuffer;
+	std::vector<uint8_t> ramBuffer;
+	
+	// Current job
+	const uint8_t* inputs = nullptr;
+	uint32_t frames = 0;
+	std::atomic<size_t> next { 0 };
+	std::atomic<size_t> remaining { 0 };
+	
+	// Pool
+	std::vector<std::thread> workers;
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::condition_variable done;
+	uint64_t generation = 0;
+	bool stopping = false;
+};
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Plain C version of VecEnv, for bindings (ctypes, cffi, ..).
+ * Buffers are owned by the environment, and stay valid until it's destroyed.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct gb_vecenv gb_vecenv;
+
+/**
+ * 'threads'    - 0 for one per core
+ * 'recompiler' - Non-zero to use the recompiler, where available
+ * 'shades'     - Non-zero for 0-3 shades instead of 0-255 grayscale
+ * 'seed'       - For the power up RAM contents, everything else is deterministic
+ * Returns NULL if the ROM is too small to be one.
+ */
+gb_vecenv* gb_vecenv_create(const uint8_t* rom, size_t romSize, size_t count,
+							uint32_t threads, int recompiler, int shades, uint32_t seed);
+void gb_vecenv_destroy(gb_vecenv* env);
+
+// One joypad state per instance, see Joypad::getState
+void gb_vecenv_step(gb_vecenv* env, const uint8_t* inputs, uint32_t frames);
+
+// Negative for all of them
+void gb_vecenv_reset(gb_vecenv* env, ptrdiff_t index);
+
+void gb_vecenv_watch(gb_vecenv* env, const uint16_t* addresses, size_t count);
+
+size_t gb_vecenv_size(const gb_vecenv* env);
+
+// count x 144 x 160
+const uint8_t* gb_vecenv_screens(const gb_vecenv* env);
+
+// count x watched
+const uint8_t* gb_vecenv_ram(const gb_vecenv* env);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,58 @@
+#include "AudioOutput.h"
+
+#include <iostream>
+
+#include <SDL.h>
+
+#include "../APU/APU.h"
+
+bool AudioOutput::open(APU& apu) {
+	// https://www.libsdl.org/release/SDL-1.2.15/docs/html/guideaudioexamples.html
+	if (SDL_InitSubSystem(SDL_INIT_AUDIO) < 0) {
+		std::cerr << "Failed to initialize SDL: " << SDL_GetError() << std::endl;
+		return false;
+	}
+	
+	SDL_AudioSpec want;
+	
+	// Clear the structure
+	SDL_memset(&want, 0, sizeof(want));
+	want.freq = 44100;
+	want.format = /*AUDIO_S16SYS*/AUDIO_U8;
+	want.channels = 2;
+	want.samples = /*44100 / 60*//*4096*/1024;
+	want.callback = fill_audio;
+	want.userdata = &apu;
+	
+	if (SDL_OpenAudio(&want, NULL) < 0) {
+		std::cerr << "Failed to open audio: " << SDL_GetError() << std::endl;
+		return false;
+	}
+	
+	opened = true;
+	SDL_PauseAudio(0); // Start audio playback
+	
+	return true;
+}
+
+void AudioOutput::close() {
+	if (!opened)
+		return;
+	
+	SDL_CloseAudio();
+	opened = false;
+}
+
+void AudioOutput::lock() {
+	if (opened)
+		SDL_LockAudio();
+}
+
+void AudioOutput::unlock() {
+	if (opened)
+		SDL_UnlockAudio();
+}
+
+void AudioOutput::fill_audio(void* userdata, uint8_t* stream, int len) {
+	static_cast<APU*>(userdata)->generateSamples(stream, len);
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+
+class APU;
+
+/**
+ * Owns the SDL audio device.
+ *
+ * The APU itself doesn't know anything about SDL,
+ * this just pulls samples out of it whenever SDL asks for more.
+ */
+
+class AudioOutput {
+public:
+	bool open(APU& apu);
+	void close();
+	
+	// Holds off the callback, while the APU is in a state that shouldn't be heard
+	void lock();
+	void unlock();
+	
+private:
+	static void fill_audio(void* userdata, uint8_t* stream, int len);
+	
+private:
+	bool opened = false;
+};
@@ -0,0 +1,95 @@
+#include "Window.h"
+
+#include <iostream>
+
+#include "SDL.h"
+
+bool Window::create(uint32_t width, uint32_t height, uint32_t scale) {
+	this->width = width;
+	this->height = height;
+	
+	// Decide GL+GLSL versions
+#if defined(IMGUI_IMPL_OPENGL_ES2)
+	// GL ES 2.0 + GLSL 100
+	const char* glsl_version = "#version 100";
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS, 0);
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_ES);
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 2);
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 0);
+#elif defined(__APPLE__)
+	// GL 3.2 Core + GLSL 150
+	const char* glsl_version = "#version 150";
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS, SDL_GL_CONTEXT_FORWARD_COMPATIBLE_FLAG); // Always required on Mac
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 2);
+#else
+	// GL 3.0 + GLSL 130
+	const char* glsl_version = "#version 130";
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS, 0);
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 0);
+#endif
+
+	// From 2.0.18: Enable native IME.
+#ifdef SDL_HINT_IME_SHOW_UI
+	SDL_SetHint(SDL_HINT_IME_SHOW_UI, "1");
+#endif
+	
+	SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
+	SDL_GL_SetAttribute(SDL_GL_DEPTH_SIZE, 24);
+	SDL_GL_SetAttribute(SDL_GL_STENCIL_SIZE, 8);
+	
+	SDL_WindowFlags window_flags = (SDL_WindowFlags)(SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE | SDL_WINDOW_ALLOW_HIGHDPI);
+	
+	SDL_CreateWindowAndRenderer(width * scale, height * scale, window_flags, &window, &renderer);
+	
+	if (window == nullptr) {
+		std::cerr << "Window could not be created SDL_Error: " << SDL_GetError() << '\n';
+		return false;
+	}
+	
+	sdl_context = SDL_GL_CreateContext(window);
+	if (sdl_context == nullptr) {
+		std::cerr << "OpenGL context could not be created SDL_Error: " << SDL_GetError() << '\n';
+		return false;
+	}
+	
+	SDL_GL_MakeCurrent(window, sdl_context);
+	SDL_GL_SetSwapInterval(1); // Enable vsync
+	
+	if(renderer == nullptr) {
+		std::cerr << "Renderer could not be created SDL_Error: " << SDL_GetError() << '\n';
+		return false;
+	}
+	
+	texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888,
+											SDL_TEXTUREACCESS_STREAMING,
+											width, height);
+	
+	if (texture == nullptr) {
+		std::cerr << "Texture could not be created SDL_Error: " << SDL_GetError() << '\n';
+		return false;
+	}
+	
+	std::cerr << "Main window created successfully\n";
+	
+	return true;
+}
+
+void Window::destroy() {
+	if(texture) SDL_DestroyTexture(texture);
+	if(sdl_context) SDL_GL_DeleteContext(sdl_context);
+	if(renderer) SDL_DestroyRenderer(renderer);
+	if(window) SDL_DestroyWindow(window);
+	
+	texture = nullptr;
+	sdl_context = nullptr;
+	renderer = nullptr;
+	window = nullptr;
+}
+
+void Window::upload(const uint32_t* pixels) {
+	SDL_UpdateTexture(texture, nullptr, pixels, static_cast<int>(width * sizeof(uint32_t)));
+}
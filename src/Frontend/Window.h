@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+
+#include <SDL_render.h>
+#include <SDL_video.h>
+
+/**
+ * SDL side of the screen.
+ *
+ * The PPU only writes into its own framebuffer,
+ * this is what takes that and shows it.
+ */
+
+class Window {
+public:
+	bool create(uint32_t width, uint32_t height, uint32_t scale);
+	void destroy();
+	
+	// Uploads a full ARGB8888 frame into 'texture'
+	void upload(const uint32_t* pixels);
+	
+public:
+	SDL_Window* window = nullptr;
+	SDL_GLContext sdl_context = nullptr;
+	SDL_Renderer* renderer = nullptr;
+	
+	SDL_Texture* texture = nullptr;
+	
+private:
+	uint32_t width = 0;
+	uint32_t height = 0;
+};
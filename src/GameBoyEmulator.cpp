@@ -31,12 +31,21 @@
 #include "Memory/HRAM.h"
 #include "Memory/WRAM.h"
 #include "Memory/MBC/MBC.h"
+#include "Memory/RomImage.h"
 
 #include "Pipeline/PPU.h"
 #include "Pipeline/LCDC.h"
 #include "Pipeline//VRAM.h"
 #include "Pipeline/OAM.h"
 
+#include "Core/GameBoy.h"
+#include "Core/Movie.h"
+#include "Core/Rewind.h"
+#include "Core/Trace.h"
+
+#include "Frontend/Window.h"
+#include "Frontend/AudioOutput.h"
+
 /*
  * GOOD GUIDES;
  *
@@ -115,6 +124,49 @@ std::optional<uint8_t> stdoutprinter(uint8_t value) {
     return std::nullopt;
 }
 
+/**
+ * Prints how fast 'frames' frames were emulated, and how that
+ * compares to real hardware (60 frames a second).
+ */
+void printBenchmark(const GameBoy& gb, uint64_t frames, double seconds) {
+    if (seconds <= 0)
+        seconds = 1e-9;
+    
+    const uint64_t accesses = gb.mmu.reads + gb.mmu.writes;
+    
+    printf("\n--- Benchmark (%s) ---\n", gb.recompiler ? "recompiler" : "interpreter");
+    printf("Frames:        %llu in %.3fs\n", static_cast<unsigned long long>(frames), seconds);
+    printf("Frames/s:      %.1f\n", frames / seconds);
+    printf("Instructions/s %.0f (%llu total)\n", gb.cpu.instructions / seconds, static_cast<unsigned long long>(gb.cpu.instructions));
+    printf("MMU accesses/s %.0f (%llu total)\n", accesses / seconds, static_cast<unsigned long long>(accesses));
+    printf("Speed:         %.2fx real hardware\n", frames / 60.0 / seconds);
+}
+
+/**
+ * Hot spots into 'path', and the call stacks,
+ * for flame graphs, into 'path'.folded.
+ */
+void writeProfile(const GameBoy& gb, const std::string& path) {
+    if (!Profiler::enabled) {
+        std::cerr << "--profile needs a build with -DGB_PROFILER=ON\n";
+        return;
+    }
+    
+    FILE* report = fopen(path.c_str(), "w");
+    FILE* folded = fopen((path + ".folded").c_str(), "w");
+    
+    if (report) gb.cpu.profiler.writeReport(report);
+    if (folded) gb.cpu.profiler.writeFolded(folded);
+    
+    if (report) fclose(report);
+    if (folded) fclose(folded);
+    
+    if (!report || !folded)
+        std::cerr << "Couldn't write the profile to " << path << '\n';
+    else
+        printf("Wrote the profile to %s and %s.folded\n", path.c_str(), path.c_str());
+}
+
 // TODO; Move this into a different class:
 class Disassembler {
 public:
@@ -356,9 +408,6 @@ private:
 };
 
 int main(int argc, char* argv[]) {
-    using std::ifstream;
-    using std::ios;
-    
     // GAMES
     
     // Games that work
@@ -383,6 +432,57 @@ int main(int argc, char* argv[]) {
      */
     std::string filename = "Roms/SpongeBob SquarePants - Legend of the Lost Spatula (U) [C][!].gbc"; // Uses MBC5
     
+    /**
+     * --jit          - x86-64 recompiler, falls back to the interpreter if it can't
+     * --turbo        - No frame pacing, only presents ~60 times a second
+     * --bench N      - Runs N frames headless as fast as possible, then exits
+     * --run-ahead N  - Shows N frames ahead to hide input lag
+     * --record F     - Records the input into the movie F, written on exit
+     * --play F       - Replays the movie F headless as fast as possible, then exits,
+     *                  with 1 if it didn't end up where the recording did
+     * --profile F    - Writes where the CPU spent its time to F on exit (GB_PROFILER builds)
+     * --trace F      - Binary trace of every instruction into F, see gb_trace_doctor
+     * --trace-writes - Also puts every memory write in the trace
+     * Anything else is the ROM to run.
+     */
+    bool useRecompiler = false;
+    bool turbo = false;
+    uint64_t benchFrames = 0;
+    int runAheadFrames = 0;
+    std::string recordPath;
+    std::string playPath;
+    std::string profilePath;
+    std::string tracePath;
+    bool traceWrites = false;
+    
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        
+        if (arg == "--jit") {
+            useRecompiler = true;
+        } else if (arg == "--turbo") {
+            turbo = true;
+        } else if (arg == "--bench" && i + 1 < argc) {
+            benchFrames = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--run-ahead" && i + 1 < argc) {
+            runAheadFrames = std::atoi(argv[++i]);
+        } else if (arg == "--record" && i + 1 < argc) {
+            recordPath = argv[++i];
+        } else if (arg == "--play" && i + 1 < argc) {
+            playPath = argv[++i];
+        } else if (arg == "--profile" && i + 1 < argc) {
+            profilePath = argv[++i];
+        } else if (arg == "--trace" && i + 1 < argc) {
+            tracePath = argv[++i];
+        } else if (arg == "--trace-writes") {
+            traceWrites = true;
+        } else if (arg.rfind("--", 0) == 0) {
+            std::cerr << "Unknown option: " << arg << '\n';
+        } else {
+            filename = arg;
+        }
+    }
+    
     /**
      * Fixing the issue with,
      * WRAM and HRAM, fixed,
@@ -615,20 +715,10 @@ int main(int argc, char* argv[]) {
     //std::string filename = "Roms/tests/turtle-tests/window_y_trigger/window_y_trigger.gb"; // Passed
     //std::string filename = "Roms/tests/turtle-tests/window_y_trigger_wx_offscreen/window_y_trigger_wx_offscreen.gb"; // Passed
     
-    ifstream stream(filename.c_str(), ios::binary | ios::ate);
+    // Mapped, not copied
+    RomHandle rom = RomImage::open(filename);
     
-    if (!stream.good()) {
-        std::cerr << "Cannot read from file: " << filename << '\n';
-    }
-    
-    auto fileSize = stream.tellg();
-    stream.seekg(0, ios::beg);
-    
-    std::vector<uint8_t> memory(fileSize);
-    
-    if (!stream.read(reinterpret_cast<char*>(memory.data()), fileSize)) {
-        std::cerr << "Error reading file!" << '\n';
-        
+    if (!rom) {
         return 1;
     }
     
@@ -652,63 +742,93 @@ int main(int argc, char* argv[]) {
         0xF5, 0x06, 0x19, 0x78, 0x86, 0x23, 0x05, 0x20, 0xFB, 0x86, 0x00, 0x00, 0x3E, 0x01, 0xE0, 0x50
     };
     
-    Cartridge cartridge;
-    
-    // Gather cartridge information
-    cartridge.decode(memory);
-    MBC mbc(cartridge, memory);
+    // Owns the whole CPU/MMU/PPU/APU graph
+    GameBoy gb(rom, bootDMG);
     
-    InterruptHandler interruptHandler;
+    // Listen.. I'm too lazy to rename everything below
+    Cartridge& cartridge = gb.cartridge;
+    MBC& mbc = gb.mbc;
+    Joypad& joypad = gb.joypad;
+    Serial& serial = gb.serial;
+    APU& apu = gb.apu;
+    MMU& mmu = gb.mmu;
+    PPU* ppu = &gb.ppu;
+    CPU& cpu = gb.cpu;
     
-    // I/O
-    LCDC lcdc;
-    Joypad joypad;
-    Serial serial;
-    Timer timer;
-    
-    OAM oam;
-    
-    // Init memories
-    /**
-     * I have no clue what's happening,
-     * but writting to hram sometimes,
-     * fucks up wram??? And vice versa..
-     * 
-     * I am so confused rn.
-     * 
-     * Future me; I was being too stupid,
-     * WRAM and VRAM's sizes were too small.
-     */
-    WRAM wram;
-    HRAM hram;
-    
-    VRAM vram(lcdc);
+	Disassembler disassembler;
     
-    PPU* ppu;
-    APU apu;
+    serial.set_callback(stdoutprinter);
     
-    // Create MMU
-    MMU mmu(interruptHandler, serial, joypad, mbc, wram,
-        hram, vram, lcdc, timer, oam,
-        *(new PPU(vram, oam, lcdc, mmu)),
-        apu, bootDMG, memory);
+    if (useRecompiler)
+        gb.setBackend(Backend::Recompiler);
     
-    // Listen.. I'm too lazy to deal with this crap
-    ppu = &mmu.ppu;
+    // Stops (and writes out the rest) when it goes out of scope
+    Tracer tracer;
     
-    CPU cpu(interruptHandler, mmu);
+    if (!tracePath.empty())
+        tracer.start(gb, tracePath, traceWrites);
     
-	Disassembler disassembler;
+    // No SDL at all, just emulation
+    if (benchFrames > 0) {
+        auto start = std::chrono::high_resolution_clock::now();
+        
+        for (uint64_t i = 0; i < benchFrames; i++) {
+            gb.runFrame();
+        }
+        
+        std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+        printBenchmark(gb, benchFrames, elapsed.count());
+        
+        if (!profilePath.empty())
+            writeProfile(gb, profilePath);
+        
+        return 0;
+    }
     
-    serial.set_callback(stdoutprinter);
+    // Same, but with the movie's input, the state hash should match on any machine
+    if (!playPath.empty()) {
+        Movie movie;
+        
+        if (!movie.load(playPath) || !movie.start(gb))
+            return 1;
+        
+        auto start = std::chrono::high_resolution_clock::now();
+        
+        while (movie.playFrame(gb)) {}
+        
+        std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+        printBenchmark(gb, movie.frames(), elapsed.count());
+        
+        std::vector<uint8_t> state;
+        gb.saveState(state);
+        
+        const uint64_t stateHash = Movie::hash(state);
+        printf("State hash:    %016llx\n", static_cast<unsigned long long>(stateHash));
+        
+        // Anything else means it didn't play back exactly as it was recorded
+        const bool matches = stateHash == movie.endHash();
+        
+        if (!matches)
+            printf("Desynced, the recording ended at %016llx\n", static_cast<unsigned long long>(movie.endHash()));
+        
+        if (!profilePath.empty())
+            writeProfile(gb, profilePath);
+        
+        return matches ? 0 : 1;
+    }
     
     if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO) != 0) {
         std::cerr << "SDL could not initialize SDL_Error: " << SDL_GetError() << '\n';
         return -1;
     }
     
-    ppu->createWindow();
-    apu.init();
+    Window window;
+    if (!window.create(PPU::SCREEN_WIDTH, PPU::SCREEN_HEIGHT, 6)) {
+        return -1;
+    }
+    
+    AudioOutput audio;
+    audio.open(apu);
     
     // Setup Dear ImGui context
     IMGUI_CHECKVERSION();
@@ -730,16 +850,14 @@ int main(int argc, char* argv[]) {
     }
     
     // Setup Platform/Renderer backends
-    ImGui_ImplSDL2_InitForSDLRenderer(ppu->window, ppu->renderer);
-    ImGui_ImplSDLRenderer2_Init(ppu->renderer);
+    ImGui_ImplSDL2_InitForSDLRenderer(window.window, window.renderer);
+    ImGui_ImplSDLRenderer2_Init(window.renderer);
     
     // Load save
     mmu.mbc.load("Saves/" + cartridge.title + "/save.bin");
     
     bool running = true;
     
-    const double CLOCK_SPEED_NORMAL = 4194304; // 4.194304 MHz
-    const double CLOCK_SPEED_DOUBLE = 8388608; // 8.388608 MHz
     const int FPS = 60;
     
     // Time tracking variables
@@ -772,11 +890,35 @@ int main(int argc, char* argv[]) {
     bool singleStep = false;
     bool step       = false;
     
-    uint64_t totalCyclesThisFrame = 0;
+    // Joypad state from the keyboard, only handed over at the start of a frame
+    uint8_t input = 0;
+    bool frameStart = true;
+    
+    Movie movie;
+    
+    /**
+     * The audio callback samples the channels on its own thread,
+     * so every state save/load below happens with it waiting.
+     */
+    if (!recordPath.empty()) {
+        audio.lock();
+        movie.record(gb);
+        audio.unlock();
+    }
+    
+    // For --turbo
+    uint64_t emulatedFrames = 0;
+    auto turboStart = std::chrono::high_resolution_clock::now();
+    auto lastPresent = turboStart;
+    
+    // F5 to save, F9 to load
+    std::vector<uint8_t> quickSave;
+    
+    // Hold R to go back in time
+    Rewind rewind(gb);
+    bool rewinding = false;
     
     while (running) {
-        double cyclesPerFrame = cpu.mmu.doubleSpeed ? CLOCK_SPEED_DOUBLE / FPS : CLOCK_SPEED_NORMAL / FPS;
-        
         SDL_Event e;
         
         while (SDL_PollEvent(&e)) {
@@ -790,62 +932,112 @@ int main(int argc, char* argv[]) {
             if (e.type == SDL_KEYDOWN) {
                 switch (e.key.keysym.sym) {
                 case SDLK_RETURN: // Start
-                        joypad.pressButton(START);
+                        input |= START;
                         break;
                     case SDLK_BACKSPACE: // Select
-                        joypad.pressButton(SELECT);
+                        input |= SELECT;
                         break;
                     case SDLK_a: // A button
-                        joypad.pressButton(A);
+                        input |= A;
                         break;
                     case SDLK_s: // B button
-                        joypad.pressButton(B);
+                        input |= B;
                         break;
                     case SDLK_UP: // D-pad up
-                        joypad.pressDpad(UP);
+                        input |= UP << 4;
                         break;
                     case SDLK_DOWN: // D-pad down
-                        joypad.pressDpad(DOWN);
+                        input |= DOWN << 4;
                         break;
                     case SDLK_LEFT: // D-pad left
-                        joypad.pressDpad(LEFT);
+                        input |= LEFT << 4;
                         break;
                     case SDLK_RIGHT: // D-pad right
-                        joypad.pressDpad(RIGHT);
+                        input |= RIGHT << 4;
+                        break;
+                    case SDLK_F5:
+                        audio.lock();
+                        gb.saveState(quickSave);
+                        audio.unlock();
+                        printf("Saved state (%zu bytes)\n", quickSave.size());
+                        break;
+                    case SDLK_F9:
+                        // Would break the movie
+                        if(movie.isRecording())
+                            break;
+                        
+                        if(quickSave.empty())
+                            break;
+                        
+                        audio.lock();
+                        
+                        if(gb.loadState(quickSave))
+                            frameStart = true;
+                        
+                        audio.unlock();
+                        break;
+                    case SDLK_r:
+                        rewinding = !movie.isRecording();
                         break;
                 }
             }
             else if (e.type == SDL_KEYUP) {
                 switch (e.key.keysym.sym) {
                     case SDLK_RETURN: // Start
-                        joypad.releaseButton(START);
+                        input &= ~START;
                         break;
                     case SDLK_BACKSPACE: // Select
-                        joypad.releaseButton(SELECT);
+                        input &= ~SELECT;
                         break;
                     case SDLK_a: // A button
-                        joypad.releaseButton(A);
+                        input &= ~A;
                         break;
                     case SDLK_s: // B button
-                        joypad.releaseButton(B);
+                        input &= ~B;
                         break;
                     case SDLK_UP: // D-pad up
-                        joypad.releaseDpad(UP);
+                        input &= ~(UP << 4);
                         break;
                     case SDLK_DOWN: // D-pad down
-                        joypad.releaseDpad(DOWN);
+                        input &= ~(DOWN << 4);
                         break;
                     case SDLK_LEFT: // D-pad left
-                        joypad.releaseDpad(LEFT);
+                        input &= ~(LEFT << 4);
                         break;
                     case SDLK_RIGHT: // D-pad right
-                        joypad.releaseDpad(RIGHT);
+                        input &= ~(RIGHT << 4);
+                        break;
+                    case SDLK_r:
+                        rewinding = false;
                         break;
                     }
             }
         }
         
-        while (totalCyclesThisFrame < cyclesPerFrame && (singleStep ? step : true)) {
+        // One snapshot back per frame, so rewinding runs at 'interval' times the speed
+        if (rewinding) {
+            audio.lock();
+            
+            if(rewind.rewind())
+                frameStart = true;
+            
+            audio.unlock();
+            
+            // The run-ahead picture is from before
+            gb.runAhead(0);
+        }
+        
+        if (frameStart && !rewinding && (!singleStep || step)) {
+            if (movie.isRecording())
+                movie.recordFrame(gb, input);
+            else
+                joypad.setState(input);
+            
+            frameStart = false;
+        }
+        
+        // Frames have to end exactly where 'runFrame' ends them, or movies desync
+        while (!rewinding && !gb.frameDone() && (singleStep ? step : true)) {
             if(singleStep) {
                 if(!step)
                     continue;
@@ -853,49 +1045,41 @@ int main(int argc, char* argv[]) {
                 step = false;
             }
             
-            uint16_t cycles = cpu.cycle();
-			
-        	if(cpu.stop) {
-        		cpu.stopTimer -= cycles;
-				
-        		if(cpu.stopTimer <= 0) {
-        			cpu.stop = false;
-        		}
-        	}
-			
-            // TODO; I'm unsure about the order, but this makes sense?
-            timer.tick(cycles * (cpu.mmu.doubleSpeed ? 2 : 1), !cpu.stop);
-
-            cpu.mmu.tick(cycles);
-            ppu->tick((cycles / (cpu.mmu.doubleSpeed ? 2 : 1)) + cpu.mmu.cycles);
+            gb.frameCycles += gb.step();
+        }
         
-            cpu.mmu.cycles = 0;
-            totalCyclesThisFrame += cycles;
+        // Fast-forwarded HALTs can overshoot, keep the rest for the next frame
+        if(gb.frameDone()) {
+            gb.endFrame();
+            emulatedFrames++;
+            frameStart = true;
             
-            // Apply interrupts
-            cpu.interruptHandler.IF |= timer.interrupt;
-            timer.interrupt = 0;
-            
-            cpu.interruptHandler.IF |= cpu.mmu.joypad.interrupt;
-            cpu.mmu.joypad.interrupt = 0;
+            // The audio callback waits for the snapshot, and rather than hearing frames that get thrown away
+            audio.lock();
+            rewind.frame();
+            gb.runAhead(static_cast<uint32_t>(runAheadFrames));
+            audio.unlock();
+        }
+        
+        // Only bother drawing anything ~60 times a second
+        if (turbo) {
+            auto now = std::chrono::high_resolution_clock::now();
             
-            cpu.interruptHandler.IF |= ppu->interrupt;
-            ppu->interrupt = 0;
+            if (now - lastPresent < std::chrono::milliseconds(16))
+                continue;
             
-            cpu.interruptHandler.IF |= cpu.mmu.serial.interrupt;
-            cpu.mmu.serial.interrupt = 0;
+            lastPresent = now;
         }
         
-        if(totalCyclesThisFrame >= cyclesPerFrame) {
-            totalCyclesThisFrame = 0;
-        }
+        // Push whatever the PPU has drawn so far
+        window.upload(gb.screen());
         
         ImGui_ImplSDLRenderer2_NewFrame();
         ImGui_ImplSDL2_NewFrame();
         ImGui::NewFrame();
     	
         ImGui::Begin("Game Boy");
-            ImGui::Image((void*)(intptr_t)ppu->texture, ImVec2(ImGui::GetWindowSize().y, ImGui::GetWindowSize().y - 48));
+            ImGui::Image((void*)(intptr_t)window.texture, ImVec2(ImGui::GetWindowSize().y, ImGui::GetWindowSize().y - 48));
         ImGui::End();
         
         ImGui::Begin("CPU");
@@ -913,6 +1097,28 @@ int main(int argc, char* argv[]) {
     	ImGui::Text(("HL: " + std::to_string(cpu.HL.H) + " - " + std::to_string(cpu.HL.L) + " = " + std::to_string(cpu.HL.get())).c_str());
     	ImGui::Text(("SP: " + std::to_string(cpu.SP)).c_str());
     	
+    	ImGui::Spacing();
+    	
+    	ImGui::Checkbox("Skip idle loops", &gb.skipIdleLoops);
+    	
+    	bool lcdColors = ppu->getColorCorrection() == PPU::ColorCorrection::LCD;
+    	if(ImGui::Checkbox("LCD color correction", &lcdColors)) {
+    		ppu->setColorCorrection(lcdColors ? PPU::ColorCorrection::LCD : PPU::ColorCorrection::Raw);
+    	}
+    	ImGui::Text(("HALT cycles skipped: " + std::to_string(gb.haltCyclesSkipped)).c_str());
+    	ImGui::Text(("Idle loop cycles skipped: " + std::to_string(gb.idleCyclesSkipped)).c_str());
+    	
+    	ImGui::Spacing();
+    	
+    	ImGui::Text("Rewind (hold R): %zu snapshots, %.1fs", rewind.snapshots(), rewind.seconds());
+    	ImGui::Text("Rewind memory: %.2f / %.2f MB", rewind.memoryUsed() / (1024.0 * 1024.0), rewind.capacity / (1024.0 * 1024.0));
+    	ImGui::Text("Rewind capture: %.1f us", rewind.lastCaptureMicros);
+    	
+    	ImGui::Spacing();
+    	
+    	ImGui::SliderInt("Run-ahead frames", &runAheadFrames, 0, 4);
+    	ImGui::Text("Run-ahead: %.1f us", runAheadFrames > 0 ? gb.runAheadMicros : 0.0);
+    	
         ImGui::End();
 		
     	// TODO; Move this to the APU
@@ -961,9 +1167,9 @@ int main(int argc, char* argv[]) {
         }
         
         ImGui::Render();
-        SDL_RenderClear(ppu->renderer);
-        ImGui_ImplSDLRenderer2_RenderDrawData(ImGui::GetDrawData(), ppu->renderer);
-        SDL_RenderPresent(ppu->renderer);
+        SDL_RenderClear(window.renderer);
+        ImGui_ImplSDLRenderer2_RenderDrawData(ImGui::GetDrawData(), window.renderer);
+        SDL_RenderPresent(window.renderer);
         
         frames++;
         
@@ -975,7 +1181,7 @@ int main(int argc, char* argv[]) {
         double targetFrameTime = 1000.0 / FPS;
         
         // Sleep to limit frame rate if we are running too fast
-        if (frameTime < targetFrameTime) {
+        if (!turbo && frameTime < targetFrameTime) {
             frames = 0;
             std::this_thread::sleep_for(std::chrono::milliseconds(static_cast<int>(targetFrameTime - frameTime)));
         }
@@ -985,8 +1191,20 @@ int main(int argc, char* argv[]) {
     
     mbc.save("Saves/" + cartridge.title + "/save.bin");
     
+    if (movie.isRecording() && movie.save(recordPath))
+        printf("Recorded %zu frames into %s\n", movie.frames(), recordPath.c_str());
+    
+    if (turbo) {
+        std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - turboStart;
+        printBenchmark(gb, emulatedFrames, elapsed.count());
+    }
+    
+    if (!profilePath.empty())
+        writeProfile(gb, profilePath);
+    
     // Cleanup code
-    SDL_DestroyWindow(ppu->window);
+    audio.close();
+    window.destroy();
     SDL_Quit();
     
     return 0;
@@ -3,6 +3,7 @@
 // https://gbdev.io/pandocs/Interrupts.html
 
 class CPU;
+class Serializer;
 
 class InterruptHandler {
 public:
@@ -13,6 +14,8 @@ public:
 	uint8_t fetch8(uint16_t address);
 	void write8(uint16_t address, uint8_t data);
 	
+	void serialize(Serializer& s);
+	
 public:
 	/**
 	 * Interrupt Master Enable. A flag that is used to determine,
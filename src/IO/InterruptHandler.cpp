@@ -2,6 +2,7 @@
 
 #include "../CPU/CPU.h"
 #include "InterrupHandler.h"
+#include "../Utility/Serializer.h"
 
 uint8_t InterruptHandler::handleInterrupt(CPU& cpu) {
 	if(IME || cpu.halted) {
@@ -72,3 +73,9 @@ void InterruptHandler::write8(uint16_t address, uint8_t data) {
  		IE = data;
 	}
 }
+
+void InterruptHandler::serialize(Serializer& s) {
+	s(IME);
+	s(IE);
+	s(IF);
+}
@@ -1,6 +1,7 @@
 #include "Joypad.h"
 
 #include "../Utility/Bitwise.h"
+#include "../Utility/Serializer.h"
 
 /**
  * PLEASE NOTE;
@@ -139,3 +140,41 @@ void Joypad::releaseDpad(Dpad dpad) {
 	
 	checkForInterrupts();
 }
+
+uint8_t Joypad::getState() const {
+	return (a ? A : 0) | (b ? B : 0) | (select ? SELECT : 0) | (start ? START : 0) |
+		   (right ? RIGHT : 0) << 4 | (left ? LEFT : 0) << 4 | (up ? UP : 0) << 4 | (down ? DOWN : 0) << 4;
+}
+
+void Joypad::setState(uint8_t state) {
+	a = state & A;
+	b = state & B;
+	select = state & SELECT;
+	start = state & START;
+	
+	right = (state >> 4) & RIGHT;
+	left = (state >> 4) & LEFT;
+	up = (state >> 4) & UP;
+	down = (state >> 4) & DOWN;
+	
+	checkForInterrupts();
+}
+
+void Joypad::serialize(Serializer& s) {
+	s(interrupt);
+	
+	s(up);
+	s(down);
+	s(left);
+	s(right);
+	s(a);
+	s(b);
+	s(select);
+	s(start);
+	
+	s(button_switch);
+	s(direction_switch);
+	
+	s(prev_buttons_state);
+	s(prev_dpad_state);
+}
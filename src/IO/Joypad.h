@@ -1,6 +1,8 @@
 #pragma once
 #include <cstdint>
 
+class Serializer;
+
 // https://gbdev.io/pandocs/Joypad_Input.html
 
 enum Buttons {
@@ -28,6 +30,15 @@ public:
 	void releaseButton(Buttons button);
 	void pressDpad(Dpad dpad);
 	void releaseDpad(Dpad dpad);
+	
+	/**
+	 * Everything at once, 'Buttons' in the low nibble,
+	 * 'Dpad' in the high one. Set means pressed.
+	 */
+	uint8_t getState() const;
+	void setState(uint8_t state);
+	
+	void serialize(Serializer& s);
 
 public:
 	uint8_t interrupt = 0;
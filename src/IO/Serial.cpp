@@ -3,6 +3,8 @@
 #include <functional>
 #include <optional>
 
+#include "../Utility/Serializer.h"
+
 std::optional<uint8_t> noop(uint8_t) {
     return std::nullopt;
 }
@@ -38,3 +40,9 @@ void Serial::write8(uint16_t address, uint8_t data) {
         }
     }
 }
+
+void Serial::serialize(Serializer& s) {
+    s(interrupt);
+    s(transferData);
+    s(transferControl);
+}
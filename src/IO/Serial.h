@@ -3,6 +3,9 @@
 #include <cstdint>
 #include <functional>
 #include <optional>
+#include <utility>
+
+class Serializer;
 
 using SerialCallback = std::function<std::optional<uint8_t>(uint8_t)>;
 
@@ -10,15 +13,23 @@ class Serial {
 public:
     uint8_t fetch8(uint16_t address);
     void write8(uint16_t address, uint8_t data);
+    
+    // The callback isn't part of the state
+    void serialize(Serializer& s);
 
     void set_callback(SerialCallback cb) {
-        callback = cb;
+        callback = std::move(cb);
     }
 
     void unset_callback() {
         callback = noop;
     }
 
+    // Unsets it, handing back what was set
+    SerialCallback take_callback() {
+        return std::exchange(callback, noop);
+    }
+
     static std::optional<uint8_t> noop(uint8_t) {
         return std::nullopt;
     }
@@ -30,5 +41,6 @@ private:
     uint8_t transferData = 0;
     uint8_t transferControl = 0;
     
-    SerialCallback callback;
+    // Nothing is connected until someone sets a callback
+    SerialCallback callback = noop;
 };
@@ -3,6 +3,8 @@
 #include <cstdio>
 #include <iostream>
 
+#include "../Utility/Serializer.h"
+
 void Timer::tick(uint16_t cycles, bool tickDiv) {
 	/*+
 	 * TODO; Not sure if timers should still,
@@ -48,6 +50,33 @@ void Timer::tick(uint16_t cycles, bool tickDiv) {
 	}
 }
 
+uint32_t Timer::cyclesUntilOverflow() const {
+	if(!enabled)
+		return UINT32_MAX;
+	
+	// Same check as in 'tick', it overflows once it reaches 0xFF
+	uint32_t increments = counter >= 0xFF ? 1 : 0xFF - counter;
+	
+	// Clock speed just changed, next tick increments right away
+	if(counterTimer >= clockSpeed)
+		return 1;
+	
+	return (increments - 1) * clockSpeed + (clockSpeed - counterTimer);
+}
+
+uint32_t Timer::cyclesUntilIncrement() const {
+	uint32_t cycles = 256 - divTimer;
+	
+	if(enabled) {
+		uint32_t counterCycles = counterTimer >= clockSpeed ? 1 : clockSpeed - counterTimer;
+		
+		if(counterCycles < cycles)
+			cycles = counterCycles;
+	}
+	
+	return cycles;
+}
+
 uint8_t Timer::fetch8(uint16_t address) {
 	if(address == 0xFF04) {
 		// https://gbdev.io/pandocs/Timer_and_Divider_Registers.html#ff04--div-divider-register
@@ -122,3 +151,16 @@ void Timer::write8(uint16_t address, uint8_t data) {
 		}
 	}
 }
+
+void Timer::serialize(Serializer& s) {
+	s(interrupt);
+	s(divider);
+	s(counter);
+	s(modulo);
+	s(control);
+	s(divTimer);
+	s(counterTimer);
+	s(enabled);
+	s(clockSelected);
+	s(clockSpeed);
+}
@@ -1,6 +1,8 @@
 #pragma once
 #include <cstdint>
 
+class Serializer;
+
 // https://gbdev.io/pandocs/Timer_and_Divider_Registers.html#timer-and-divider-registers
 
 class Timer {
@@ -10,6 +12,17 @@ public:
 	uint8_t fetch8(uint16_t address);
 	void write8(uint16_t address, uint8_t data);
 	
+	/**
+	 * T-Cycles (at timer speed) until TIMA overflows,
+	 * UINT32_MAX if the timer is off.
+	 */
+	uint32_t cyclesUntilOverflow() const;
+	
+	// T-Cycles (at timer speed) until DIV or TIMA change
+	uint32_t cyclesUntilIncrement() const;
+	
+	void serialize(Serializer& s);
+	
 public:
 	// To send an interrupt if it occurs
 	uint8_t interrupt = 0;
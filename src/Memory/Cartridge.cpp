@@ -2,9 +2,9 @@
 
 #include <iostream>
 
-Mode Cartridge::mode = DMG;
+#include "RomImage.h"
 
-void Cartridge::decode(const std::vector<uint8_t>& data) {
+void Cartridge::decode(const RomImage& data) {
     // From 0x100 - 0x014F
     
     // Information provided from; https://gbdev.io/pandocs/The_Cartridge_Header.html
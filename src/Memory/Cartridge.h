@@ -6,6 +6,8 @@
 
 #include "enums/CartridgeTypes.h"
 
+class RomImage;
+
 enum Mode {
     //Classic,
     DMG,
@@ -14,9 +16,8 @@ enum Mode {
 
 class Cartridge {
 public:
-    void decode(const std::vector<uint8_t>& data);
+    void decode(const RomImage& data);
     
-    static Mode mode;
 private:
     enums::CartridgeType getCartridgeType(uint8_t data);
     const char* cartridgeTypeToString(enums::CartridgeType type);
@@ -32,4 +33,6 @@ public:
     uint16_t ramBanks = 0;
     
     enums::CartridgeType type = enums::UNKNOWN_CARTRIDGE;
+    
+    Mode mode = DMG;
 };
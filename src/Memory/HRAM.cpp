@@ -3,6 +3,8 @@
 #include <iostream>
 #include <string>
 
+#include "../Utility/Serializer.h"
+
 uint8_t HRAM::fetch8(uint16_t address) {
 	if(address >= 127) {
 		std::cerr << "OUT OF RANGE!\n";
@@ -18,3 +20,7 @@ void HRAM::write8(uint16_t address, uint8_t data) {
 	
     RAM[address] = data;
 }
+
+void HRAM::serialize(Serializer& s) {
+    s(RAM);
+}
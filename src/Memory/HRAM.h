@@ -2,12 +2,16 @@
 
 #include <cstdint>
 
+class Serializer;
+
 // https://gbdev.io/pandocs/MBC1.html#00003fff--rom-bank-x0-read-only
 class HRAM {
 public:
     uint8_t fetch8(uint16_t address);
     void write8(uint16_t address, uint8_t data);
     
+    void serialize(Serializer& s);
+    
 private:
     uint8_t RAM[127] = { 0 }; // 127 bytes
 };
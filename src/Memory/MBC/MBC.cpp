@@ -2,6 +2,8 @@
 #include <fstream>
 #include <iostream>
 
+#include "../../Utility/Serializer.h"
+
 #include "MBCS/MBC0/MBC0.h"
 #include "MBCS/MBC1/MBC1.h"
 #include "MBCS/MBC3/MBC3.h"
@@ -11,7 +13,8 @@ MBC::MBC() {
 	
 }
 
-MBC::MBC(Cartridge cartridge, std::vector<uint8_t> rom) : data(rom) {
+MBC::MBC(const Cartridge& cartridge, RomHandle rom) {
+	this->rom = rom;
 	this->title = cartridge.title;
 	
 	switch (cartridge.type) {
@@ -68,6 +71,14 @@ void MBC::write(uint16_t address, uint8_t data) {
 	curMBC->write8(address, data);
 }
 
+uint32_t MBC::romOffset(uint16_t address) {
+	// Unsupported cartridge type
+	if(!curMBC)
+		return address;
+	
+	return curMBC->getRomOffset(address);
+}
+
 uint8_t MBC::fetch8(uint16_t address) {
 	return 0;
 }
@@ -76,6 +87,23 @@ void MBC::write8(uint16_t address, uint8_t data) {
 	
 }
 
+uint32_t MBC::getRomOffset(uint16_t address) {
+	return address;
+}
+
+void MBC::serializeBanks(Serializer&) {
+	
+}
+
+void MBC::serialize(Serializer& s) {
+	// Unsupported cartridge type
+	if(!curMBC)
+		return;
+	
+	s.vector(curMBC->eram);
+	curMBC->serializeBanks(s);
+}
+
 void MBC::load(const std::string& path) {
 	std::ifstream stream(path, std::ios::binary);
 	
@@ -4,40 +4,56 @@
 #include <memory>
 
 #include "../Cartridge.h"
+#include "../RomImage.h"
+
+class Serializer;
 
 class MBC {
 public:
 	MBC();
-	MBC(Cartridge cartridge, std::vector<uint8_t> rom);
+	MBC(const Cartridge& cartridge, RomHandle rom);
 	
 	virtual ~MBC() = default;
 	
 	uint8_t read(uint16_t address);
 	void write(uint16_t address, uint8_t data);
 	
+	/**
+	 * Where 'address' (0x0000-0x7FFF) currently lands in the ROM,
+	 * with the current banks. Used by the CPU's decode cache.
+	 */
+	uint32_t romOffset(uint16_t address);
+	const RomImage& romData() const { return *rom; }
+	
 public:
 	void load(const std::string& path);
 	void save(const std::string& path);
 	
+	// External RAM and the current banks
+	void serialize(Serializer& s);
+	
 protected:
 	virtual uint8_t fetch8(uint16_t address);
 	virtual void write8(uint16_t address, uint8_t data);
 	
+	virtual uint32_t getRomOffset(uint16_t address);
+	
+	virtual void serializeBanks(Serializer& s);
+	
 protected:
 	uint16_t romBanks = 0;
 	
 	// Technically, this CAN be a uint8
 	uint16_t ramBanks = 0;
 	
-	std::vector<uint8_t> rom;
+	// Shared with every other MBC running the same ROM
+	RomHandle rom;
 	std::vector<uint8_t> eram;
 	
 private:
 	// Used for saving.. Ik it's scuffed
 	std::string title;
 	
-	std::vector<uint8_t> data;
-	
 	/**
 	 * Current active MBC.
 	 * 
@@ -1,14 +1,14 @@
 #include "MBC0.h"
 
-MBC0::MBC0(Cartridge cartridge, std::vector<uint8_t> rom) {
-	this->rom = rom;
+MBC0::MBC0(const Cartridge& cartridge, RomHandle rom) {
+	this->rom = std::move(rom);
 	
 	eram.resize(static_cast<size_t>(cartridge.romSize) * 1024);
 }
 
 uint8_t MBC0::fetch8(uint16_t address) {
 	if(address <= 0x7FFF)
-		return rom[address];
+		return (*rom)[getRomOffset(address)];
 	else if (address >= 0xA000 && address <= 0xBFFF) {
 		return eram[address - 0xA000];
 	}
@@ -16,6 +16,11 @@ uint8_t MBC0::fetch8(uint16_t address) {
 	return 0xFF;
 }
 
+uint32_t MBC0::getRomOffset(uint16_t address) {
+	// No banking
+	return address;
+}
+
 void MBC0::write8(uint16_t address, uint8_t data) {
 	if (address >= 0xA000 && address <= 0xBFFF) {
 		eram[address - 0xA000] = data;
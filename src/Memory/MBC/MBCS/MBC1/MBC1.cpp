@@ -5,8 +5,10 @@
 #include <ios>
 #include <iostream>
 
-MBC1::MBC1(Cartridge cartridge, std::vector<uint8_t> rom) {
-	this->rom = rom;
+#include "../../../../Utility/Serializer.h"
+
+MBC1::MBC1(const Cartridge& cartridge, RomHandle rom) {
+	this->rom = std::move(rom);
 	
 	this->romBanks = cartridge.romBanks;
 	this->ramBanks = cartridge.ramBanks;
@@ -16,21 +18,8 @@ MBC1::MBC1(Cartridge cartridge, std::vector<uint8_t> rom) {
 }
 
 uint8_t MBC1::fetch8(uint16_t address) {
-	if(address < 0x4000) { // bank 0 (fixed)
-		uint8_t bank = bankingMode ? (curRomBank & 0xE0) : 0;
-		
-		uint16_t addr = address | static_cast<uint16_t>(bank * 0x4000);
-		
-		return rom[addr];
-	} else if(address < 0x8000) {
-		size_t bank = curRomBank;
-		
-		// Bank 0 not allowed.
-		if(bank == 0)
-			bank = 1;
-		
-		size_t addr = (bank * 0x4000) | (static_cast<size_t>(address) & 0x3FFF);		
-		return rom[addr];
+	if(address < 0x8000) {
+		return (*rom)[getRomOffset(address)];
 	} else if (address >= 0xA000 && address < 0xBFFF) {
 		if(!ramEnabled)
 			return 0xFF;
@@ -43,6 +32,24 @@ uint8_t MBC1::fetch8(uint16_t address) {
 	return 0xF;
 }
 
+uint32_t MBC1::getRomOffset(uint16_t address) {
+	if(address < 0x4000) { // bank 0 (fixed)
+		uint8_t bank = bankingMode ? (curRomBank & 0xE0) : 0;
+		
+		uint16_t addr = address | static_cast<uint16_t>(bank * 0x4000);
+		
+		return addr;
+	}
+	
+	size_t bank = curRomBank;
+	
+	// Bank 0 not allowed.
+	if(bank == 0)
+		bank = 1;
+	
+	return static_cast<uint32_t>((bank * 0x4000) | (static_cast<size_t>(address) & 0x3FFF));
+}
+
 void MBC1::write8(uint16_t address, uint8_t data) {
 	if(address <= 0x1FFF) {
 		ramEnabled = (data & 0xF) == 0xA;
@@ -77,4 +84,11 @@ void MBC1::write8(uint16_t address, uint8_t data) {
 		
 		eram[(address & 0x1FFF) + (bank * 0x2000)] = data;
 	}
-}
\ No newline at end of file
+}
+
+void MBC1::serializeBanks(Serializer& s) {
+	s(bankingMode);
+	s(ramEnabled);
+	s(curRomBank);
+	s(curRamBank);
+}
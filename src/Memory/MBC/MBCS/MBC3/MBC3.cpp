@@ -2,8 +2,10 @@
 
 #include <assert.h>
 
-MBC3::MBC3(Cartridge cartridge, std::vector<uint8_t> rom) {
-	this->rom = rom;
+#include "../../../../Utility/Serializer.h"
+
+MBC3::MBC3(const Cartridge& cartridge, RomHandle rom) {
+	this->rom = std::move(rom);
 	
 	this->romBanks = cartridge.romBanks;
 	this->ramBanks = cartridge.ramBanks;
@@ -13,13 +15,11 @@ MBC3::MBC3(Cartridge cartridge, std::vector<uint8_t> rom) {
 }
 
 uint8_t MBC3::fetch8(uint16_t address) {
-	if(address <= 0x3FFF) {
-		return rom[address];
-	} else if(address >= 0x4000 && address <= 0x7FFF) {
-		size_t addr = static_cast<size_t>(curRomBank * 0x4000) | (static_cast<size_t>(address - 0x4000));
-		assert(addr < rom.size());
+	if(address <= 0x7FFF) {
+		size_t addr = getRomOffset(address);
+		assert(addr < rom->size());
 		
-		return rom[addr];
+		return (*rom)[addr];
 	} else if (address >= 0xA000 && address < 0xBFFF) {
 		size_t addr = (address - 0xA000) | (curRamBank * 0x2000);
 		assert(addr <= eram.size());
@@ -28,6 +28,14 @@ uint8_t MBC3::fetch8(uint16_t address) {
 	}
 }
 
+uint32_t MBC3::getRomOffset(uint16_t address) {
+	if(address <= 0x3FFF) {
+		return address;
+	}
+	
+	return static_cast<uint32_t>(static_cast<size_t>(curRomBank * 0x4000) | (static_cast<size_t>(address - 0x4000)));
+}
+
 void MBC3::write8(uint16_t address, uint8_t data) {
 	if(address <= 0x1FFF) {
 		ramEnabled = (data & 0xF) == 0xA;
@@ -62,3 +70,10 @@ void MBC3::write8(uint16_t address, uint8_t data) {
 		eram[addr] = data;
 	}
 }
+
+void MBC3::serializeBanks(Serializer& s) {
+	s(ramEnabled);
+	s(rtcRegister);
+	s(curRomBank);
+	s(curRamBank);
+}
@@ -5,10 +5,14 @@
 class MBC3 : public MBC {
 public:
 	MBC3() = default;
-	MBC3(Cartridge cartridge, std::vector<uint8_t> rom);
+	MBC3(const Cartridge& cartridge, RomHandle rom);
 	
 	uint8_t fetch8(uint16_t address) override;
 	void write8(uint16_t address, uint8_t data) override;
+	
+	uint32_t getRomOffset(uint16_t address) override;
+	
+	void serializeBanks(Serializer& s) override;
 
 private:
 	/**
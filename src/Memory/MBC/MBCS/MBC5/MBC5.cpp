@@ -1,7 +1,9 @@
 #include "MBD5.h"
 
-MBC5::MBC5(Cartridge cartridge, std::vector<uint8_t> rom) {
-	this->rom = rom;
+#include "../../../../Utility/Serializer.h"
+
+MBC5::MBC5(const Cartridge& cartridge, RomHandle rom) {
+	this->rom = std::move(rom);
 	
 	this->romBanks = cartridge.romBanks;
 	this->ramBanks = cartridge.ramBanks;
@@ -19,19 +21,22 @@ uint8_t MBC5::fetch8(uint16_t address) {
 		
 		return eram[(bank * 0x2000) | (address & 0x1FFF)];
 	} else {
-		size_t bank;
-		
-		if(address < 0x4000) {
-			bank = 0;
-		} else {
-			bank = curRomBank;
-		}
-		
-		size_t addr = (bank * 0x4000) | (static_cast<size_t>(address) & 0x3FFF);
-		return rom[addr];
+		return (*rom)[getRomOffset(address)];
 	}
 }
 
+uint32_t MBC5::getRomOffset(uint16_t address) {
+	size_t bank;
+	
+	if(address < 0x4000) {
+		bank = 0;
+	} else {
+		bank = curRomBank;
+	}
+	
+	return static_cast<uint32_t>((bank * 0x4000) | (static_cast<size_t>(address) & 0x3FFF));
+}
+
 void MBC5::write8(uint16_t address, uint8_t data) {
 	if(address < 0x1FFF) {
 		ramEnabled = (data & 0xF) == 0xA;
@@ -53,4 +58,11 @@ void MBC5::write8(uint16_t address, uint8_t data) {
 		
 		eram[(address & 0x1FFF) + (bank * 0x2000)] = data;
 	}
-}
\ No newline at end of file
+}
+
+void MBC5::serializeBanks(Serializer& s) {
+	s(bankingMode);
+	s(ramEnabled);
+	s(curRomBank);
+	s(curRamBank);
+}
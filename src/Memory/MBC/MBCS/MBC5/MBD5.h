@@ -5,11 +5,15 @@
 class MBC5 : public MBC {
 public:
 	MBC5() = default;
-	MBC5(Cartridge cartridge, std::vector<uint8_t> rom);
+	MBC5(const Cartridge& cartridge, RomHandle rom);
 	
 	uint8_t fetch8(uint16_t address) override;
 	void write8(uint16_t address, uint8_t data) override;
 	
+	uint32_t getRomOffset(uint16_t address) override;
+	
+	void serializeBanks(Serializer& s) override;
+	
 private:
 	/**
 	 * 0 - ROM
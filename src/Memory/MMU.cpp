@@ -14,12 +14,12 @@
 
 #include "../Pipeline/OAM.h"
 #include "../Pipeline/PPU.h"
+#include "../Utility/Serializer.h"
 #include "../Utility/Bitwise.h"
 #include "MBC/MBC.h"
 
 MMU::MMU(InterruptHandler& interruptHandler, Serial& serial, Joypad& joypad, MBC& mbc, WRAM& wram, HRAM& hram,
-    VRAM& vram, LCDC& lcdc, Timer& timer, OAM& oam, PPU& ppu, APU& apu, const std::vector<uint8_t>& bootRom,
-    const std::vector<uint8_t>& memory) 
+    VRAM& vram, LCDC& lcdc, Timer& timer, OAM& oam, PPU& ppu, APU& apu, const Cartridge& cartridge, const std::vector<uint8_t>& bootRom)
         : interruptHandler(interruptHandler),
           serial(serial),
           joypad(joypad),
@@ -32,13 +32,18 @@ MMU::MMU(InterruptHandler& interruptHandler, Serial& serial, Joypad& joypad, MBC
           oam(oam),
           ppu(ppu),
           apu(apu),
+          cartridge(cartridge),
           bootRom(bootRom) {
-    //bootRomActive = (Cartridge::mode == DMG);
+    //bootRomActive = (cartridge.mode == DMG);
+    
+    updatePages();
 }
 
 void MMU::tick(uint32_t cycles) {
     apu.tick(cycles);
     
+    const size_t activeDmas = dmas.size();
+    
     for(int i = 0; i < dmas.size(); i++) {
         // Begin transfering one byte at a time
         dmas[i].process(*this, cycles * (doubleSpeed ? 2 : 1));
@@ -49,6 +54,9 @@ void MMU::tick(uint32_t cycles) {
         }
     }
     
+    if(dmas.size() != activeDmas)
+        updatePages();
+    
     // HDMA
     // TODO; Check if this correct
     // TODO; Please rewrite this
@@ -75,7 +83,7 @@ void MMU::tick(uint32_t cycles) {
             
             enabled = false;
             this->cycles = len * 8;
-        } else if(mode == 1 && PPU::mode == PPU::HBlank) {
+        } else if(mode == 1 && ppu.mode == PPU::HBlank) {
             // HBlank - HDMA
             for(uint16_t j = 0; j < 0x10; j++) {
                 uint8_t val = fetch8(sourceIndex + j);
@@ -96,7 +104,7 @@ void MMU::tick(uint32_t cycles) {
     }
 }
 
-uint8_t MMU::fetch8(uint16_t address, bool isDma) {
+uint8_t MMU::fetchSlow(uint16_t address, bool isDma) {
     /**
      * Information of memory map is taken from;
      * https://gbdev.io/pandocs/Memory_Map.html
@@ -180,6 +188,8 @@ uint8_t MMU::fetch8(uint16_t address, bool isDma) {
             return val;
         }*/
         
+        sync(false);
+        
         return fetchIO(address);
     } else if(address >= 0xFF80 && address <= 0xFFFE) {
         return hram.fetch8(address - 0xFF80);
@@ -210,7 +220,10 @@ uint8_t MMU::fetchIO(uint16_t address, bool isDma) {
         //std::cerr << "LCD Control, Status, Position, Scrolling, and Palettes\n";
         
         // TODO; Please clean this..
-        if(address >= 0xFF40 && address <= 0xFF45 || address >= 0xFF4A && address <= 0xFF4B) {
+        if(address == 0xFF41) {
+            // STAT, the mode bits live in the PPU
+            return lcdc.fetch8(address) | ppu.mode;
+        } else if(address >= 0xFF40 && address <= 0xFF45 || address >= 0xFF4A && address <= 0xFF4B) {
             return lcdc.fetch8(address);
         } else if(address == 0xFF46) {
             //  $FF46	DMA	OAM DMA source address & start
@@ -227,7 +240,7 @@ uint8_t MMU::fetchIO(uint16_t address, bool isDma) {
         }
     } else if(address == 0xFF4D) {
         // CGB Mode only
-        if(Cartridge::mode != Color) return 0xFF;
+        if(cartridge.mode != Color) return 0xFF;
         
         return 0b01111110 | (doubleSpeed ? 0x80 : 0) | (switchArmed ? 1 : 0);
     } else if(address == 0xFF4F) {
@@ -237,37 +250,37 @@ uint8_t MMU::fetchIO(uint16_t address, bool isDma) {
         return 0xFF;
     }  else if(address == 0xFF51) {
         // https://gbdev.io/pandocs/CGB_Registers.html#ff51ff52--hdma1-hdma2-cgb-mode-only-vram-dma-source-high-low-write-only
-        if(Cartridge::mode != Color) return 0xFF;
+        if(cartridge.mode != Color) return 0xFF;
         
         return sourceLow;
         //return (source & 0xFF00) >> 8;
     } else if(address == 0xFF52) {
         // https://gbdev.io/pandocs/CGB_Registers.html#ff51ff52--hdma1-hdma2-cgb-mode-only-vram-dma-source-high-low-write-only
-        if(Cartridge::mode != Color) return 0xFF;
+        if(cartridge.mode != Color) return 0xFF;
         
         return sourceHigh;
         //return source & 0xFF;
     } else if(address == 0xFF53) {
         // https://gbdev.io/pandocs/CGB_Registers.html#ff53ff54--hdma3-hdma4-cgb-mode-only-vram-dma-destination-high-low-write-only
-        if(Cartridge::mode != Color) return 0xFF;
+        if(cartridge.mode != Color) return 0xFF;
         
         return destLow;
         //return (dest & 0xFF00) >> 8;
     } else if(address == 0xFF54) {
         // https://gbdev.io/pandocs/CGB_Registers.html#ff53ff54--hdma3-hdma4-cgb-mode-only-vram-dma-destination-high-low-write-only
-        if(Cartridge::mode != Color) return 0xFF;
+        if(cartridge.mode != Color) return 0xFF;
         
         return destHigh;
         //return dest & 0xFF;
     } else if(address == 0xFF55) {
         // https://gbdev.io/pandocs/CGB_Registers.html#ff55--hdma5-cgb-mode-only-vram-dma-lengthmodestart
-        if(Cartridge::mode != Color) return 0xFF;
+        if(cartridge.mode != Color) return 0xFF;
         
         return length | (!enabled ? 0x80 : 0);
     } else if(address >= 0xFF68 && address <= 0xFF6C) {
         return ppu.fetch8(address);
     } else if(address == 0xFF70) {
-        if(Cartridge::mode != Color) return 0xFF;
+        if(cartridge.mode != Color) return 0xFF;
 
         return wramBank & 0x7;
     }
@@ -294,9 +307,24 @@ uint16_t MMU::fetch16(uint16_t address) {
     return static_cast<uint16_t>(fetch8(address)) | (static_cast<uint16_t>(fetch8(address + 1) << 8));
 }
 
-void MMU::write8(uint16_t address, uint8_t data, bool isDma) {
+uint8_t MMU::peek(uint16_t address) {
+    if(const uint8_t* page = readPages[address >> 8])
+        return page[address & 0xFF];
+    
+    if(address >= 0xFF00 && address < 0xFF80)
+        return 0xFF;
+    
+    // Skips DMA conflicts, nothing else in there has side effects
+    return fetchSlow(address, true);
+}
+
+void MMU::writeSlow(uint16_t address, uint8_t data, bool isDma) {
+    if(writeHook && !isDma)
+        writeHook(address, data);
+    
     if (address < 0x8000) {
         mbc.write(address, data);
+        updateRomBanks();
     } else if(address >= 0x8000 && address <= 0x9FFF) {
         vram.write8(address/* - 0x8000*/, data);
     } else if (address >= 0xA000 && address <= 0xBFFF) {
@@ -312,6 +340,7 @@ void MMU::write8(uint16_t address, uint8_t data, bool isDma) {
     } else if(address >= 0xFEA0 && address <= 0xFEFF) {
         // Not usable
     } else if (address >= 0xFF00 && address <= 0xFF7F) {
+        sync(true);
         writeIO(address, data);
     } else if (address >= 0xFF80 && address <= 0xFFFE) {
         hram.write8(address - 0xFF80, data);
@@ -348,18 +377,18 @@ void MMU::writeIO(uint16_t address, uint8_t data, bool isDma) {
             
             if(address == 0xFF40) {
                 if(wasEnabled && !lcdc.enable) {
-                    if(PPU::mode == PPU::VBlank) {
+                    if(ppu.mode == PPU::VBlank) {
                         //printf("nooo...");
                         //return;
                             
                     }
 
-                    PPU::mode = PPU::HBlank;
+                    ppu.mode = PPU::HBlank;
                     lcdc.LY = 0;
                     //lcdc.WY = 0;
                     ppu.reset(0);
                 } else if(!wasEnabled && lcdc.enable) {
-                    PPU::mode = PPU::OAMScan;
+                    ppu.mode = PPU::OAMScan;
                     ppu.reset(4);
                 }
             }
@@ -377,7 +406,7 @@ void MMU::writeIO(uint16_t address, uint8_t data, bool isDma) {
             // now now, I need to instantly cause a transfer,
             // rather than the more "accurate" way
 
-            if(Cartridge::mode == Mode::DMG) {
+            if(cartridge.mode == Mode::DMG) {
                 // TODO; Not sure if this is correct?
                 // but I feel like if another DMA is being,
                 // transfered and another DMA is at the same address,
@@ -387,17 +416,19 @@ void MMU::writeIO(uint16_t address, uint8_t data, bool isDma) {
 
                 // TODO; Ik this is funky
                 DMA dma;
-                dma.setSource(data);
+                dma.setSource(data, cartridge.mode);
 
                 dma = isWithinRange(dma.source, dma.source, dmas);
                 bool exists = dma.active;
 
                 // Whether it exists or not, active it again
-                dma.activate(data/*static_cast<uint16_t>(data << 8)*/);
+                dma.activate(data, cartridge.mode/*static_cast<uint16_t>(data << 8)*/);
 
                 // Only add it again if it's active
-                if(!exists)
+                if(!exists) {
                     dmas.push_back(dma);
+                    updatePages();
+                }
 
                 return;
             }
@@ -415,7 +446,7 @@ void MMU::writeIO(uint16_t address, uint8_t data, bool isDma) {
         }
     } else if(address == 0xFF4D) {
         // CGB Mode only
-        if(Cartridge::mode != Color) return;
+        if(cartridge.mode != Color) return;
         
         // Bit 7 - Current Speed
         doubleSpeed = check_bit(data, 7);
@@ -424,35 +455,36 @@ void MMU::writeIO(uint16_t address, uint8_t data, bool isDma) {
         switchArmed = check_bit(data, 0);
     } else if(address == 0xFF4F) {
        vram.write8(address, data);
+       updatePages();
     } else if(address == 0xFF50) {
         //std::cerr << "Set to non-zero to disable boot ROM\n";
     } else if(address == 0xFF51) {
         // https://gbdev.io/pandocs/CGB_Registers.html#ff51ff52--hdma1-hdma2-cgb-mode-only-vram-dma-source-high-low-write-only
-        if(Cartridge::mode != Color) return;
+        if(cartridge.mode != Color) return;
         
         sourceLow = data;
         //source = (source & 0xFF) | static_cast<uint8_t>(data << 8);
     } else if(address == 0xFF52) {
         // https://gbdev.io/pandocs/CGB_Registers.html#ff51ff52--hdma1-hdma2-cgb-mode-only-vram-dma-source-high-low-write-only
-        if(Cartridge::mode != Color) return;
+        if(cartridge.mode != Color) return;
         
         sourceHigh = data & 0xF0;
         //source = (source & 0xFF00) | (data);
     } else if(address == 0xFF53) {
         // https://gbdev.io/pandocs/CGB_Registers.html#ff53ff54--hdma3-hdma4-cgb-mode-only-vram-dma-destination-high-low-write-only
-        if(Cartridge::mode != Color) return;
+        if(cartridge.mode != Color) return;
         
         destLow = data & 0x1F;
         //dest = (dest & 0xFF) | static_cast<uint8_t>(data << 8);
     } else if(address == 0xFF54) {
         // https://gbdev.io/pandocs/CGB_Registers.html#ff53ff54--hdma3-hdma4-cgb-mode-only-vram-dma-destination-high-low-write-only
-        if(Cartridge::mode != Color) return;
+        if(cartridge.mode != Color) return;
         
         destHigh = data & 0xF0;
         //dest = (dest & 0xFF00) | data;
     } else if(address == 0xFF55) {
         // https://gbdev.io/pandocs/CGB_Registers.html#ff55--hdma5-cgb-mode-only-vram-dma-lengthmodestart
-        if(Cartridge::mode != Color) return;
+        if(cartridge.mode != Color) return;
         
         if(/*enabled && */mode == 1 && (data & 0x80) == 0) {
             enabled = false;
@@ -477,13 +509,15 @@ void MMU::writeIO(uint16_t address, uint8_t data, bool isDma) {
     } else if(address >= 0xFF68 && address <= 0xFF6C) {
         ppu.write8(address, data);
     } else if(address == 0xFF70) {
-        if(Cartridge::mode != Color) return;
+        if(cartridge.mode != Color) return;
         
         wramBank = data & 0x7;
 
         // Only banks 1-7 matters
         if(wramBank == 0)
             wramBank = 1;
+        
+        updatePages();
     }
     
     // TODO; Addresses that don't exist
@@ -502,6 +536,66 @@ void MMU::write16(uint16_t address, uint16_t data) {
     write8(address + 1, (data >> 8) & 0xFF);
 }
 
+void MMU::updateRomBanks() {
+    romBankOffset[0] = mbc.romOffset(0x0000);
+    romBankOffset[1] = mbc.romOffset(0x4000);
+    
+    const RomImage& rom = mbc.romData();
+    
+    for(int bank = 0; bank < 2; bank++) {
+        // DMA conflicts, or a bank past the end of the ROM
+        bool slow = !dmas.empty() || static_cast<size_t>(romBankOffset[bank]) + 0x4000 > rom.size();
+        
+        for(int page = 0; page < 0x40; page++) {
+            readPages[bank * 0x40 + page] = slow ? nullptr : rom.data() + romBankOffset[bank] + page * 0x100;
+        }
+    }
+    
+    if(bootRomActive)
+        readPages[0] = nullptr;
+}
+
+void MMU::updatePages() {
+    for(int page = 0; page < 0x100; page++) {
+        readPages[page] = nullptr;
+        writePages[page] = nullptr;
+    }
+    
+    // ROM writes always go to the MBC
+    updateRomBanks();
+    
+    // VRAM, can't be read by the DMA so it's never in conflict
+    uint8_t* vramBank = vram.RAM + vram.getBank() * 0x2000;
+    
+    for(int page = 0x80; page < 0xA0; page++) {
+        readPages[page] = vramBank + (page - 0x80) * 0x100;
+        
+        // Tile data goes through VRAM, so the tile cache sees it
+        if(page >= 0x98)
+            writePages[page] = vramBank + (page - 0x80) * 0x100;
+    }
+    
+    // WRAM, echo RAM (0xE000-0xFDFF) always mirrors bank 0
+    for(int page = 0xC0; page < 0xFE; page++) {
+        uint16_t address;
+        
+        if(page < 0xD0) address = (page - 0xC0) * 0x100;
+        else if(page < 0xE0) address = (wramBank * 0x1000) | ((page - 0xD0) * 0x100);
+        else address = (page * 0x100) & 0x0FFF;
+        
+        writePages[page] = wram.data() + address;
+        
+        if(dmas.empty())
+            readPages[page] = wram.data() + address;
+    }
+    
+    if(writeHook) {
+        for(int page = 0; page < 0x100; page++) {
+            writePages[page] = nullptr;
+        }
+    }
+}
+
 void MMU::switchSpeed() {
     if(switchArmed) {
         doubleSpeed = !doubleSpeed;
@@ -514,3 +608,47 @@ void MMU::clear() {
     // TODO;
     //std::fill(std::begin(memory), std::end(memory), 0);
 }
+
+void MMU::serialize(Serializer& s) {
+    s(cycles);
+    s(bootRomActive);
+    
+    s(wramBank);
+    s(lastDma);
+    
+    s(doubleSpeed);
+    s(switchArmed);
+    
+    s(sourceLow);
+    s(sourceHigh);
+    s(destLow);
+    s(destHigh);
+    s(mode);
+    s(length);
+    s(sourceIndex);
+    s(destIndex);
+    s(enabled);
+    
+    // Field by field, copies of 'DMA' carry whatever was in the padding
+    uint32_t count = static_cast<uint32_t>(dmas.size());
+    s(count);
+    
+    // Only a couple can ever be running at once
+    if(s.isLoading()) {
+        if(count > 16) {
+            s.fail();
+            return;
+        }
+        
+        dmas.resize(count);
+    }
+    
+    for(DMA& dma : dmas) {
+        s(dma.active);
+        s(dma.source);
+        s(dma.index);
+        s(dma.remainingCycles);
+        s(dma.initialDelay);
+        s(dma.ticks);
+    }
+}
@@ -1,6 +1,7 @@
 ﻿#pragma once
 
 #include <iostream>
+#include <functional>
 #include <vector>
 #include <cassert>
 
@@ -23,6 +24,8 @@ class OAM;
 
 class APU;
 
+class Serializer;
+
 class MMU {
 public:
     /**
@@ -78,8 +81,8 @@ public:
             }
         }
         
-        void activate(uint8_t source) {
-            setSource(source);
+        void activate(uint8_t source, Mode mode) {
+            setSource(source, mode);
             
             // Transfers 4 bytes every 4 T-cycles
             remainingCycles = 640;
@@ -92,11 +95,11 @@ public:
             active = true;
         }
 
-        void setSource(uint8_t source) {
+        void setSource(uint8_t source, Mode mode) {
             // Unsure but I think this only applies,
             // to DMG? TODO; Double check this.
             
-            if(Cartridge::mode == Mode::DMG)
+            if(mode == Mode::DMG)
                 this->source = source >= 0xFE ? (0xDE00 + ((source - 0xFE) * 0x100)) : (source * 0x100);
             else
                 this->source = source * 0x100;
@@ -127,26 +130,71 @@ public:
 public:
     MMU(InterruptHandler& interruptHandler, Serial& serial, Joypad& joypad, MBC& mbc, WRAM& wram,
         HRAM& hram, VRAM& vram, LCDC& lcdc, Timer& timer, OAM& oam, PPU& ppu, APU& apu,
-        const std::vector<uint8_t>& bootRom, const std::vector<uint8_t>& memory);
+        const Cartridge& cartridge, const std::vector<uint8_t>& bootRom);
     
     void tick(uint32_t cycles);
     
-    uint8_t fetch8(uint16_t address, bool isDma = false);
+    /**
+     * Plain memory is read straight out of 'readPages',
+     * anything else (IO, cartridge RAM, OAM, DMA conflicts..)
+     * goes through the full memory map in 'fetchSlow'.
+     */
+    uint8_t fetch8(uint16_t address, bool isDma = false) {
+        reads++;
+        
+        if(const uint8_t* page = readPages[address >> 8])
+            return page[address & 0xFF];
+        
+        return fetchSlow(address, isDma);
+    }
+    
     uint8_t fetchIO(uint16_t address, bool isDma = false);
     
+    // Reads without side effects, IO registers (0xFF00-0xFF7F) read 0xFF
+    uint8_t peek(uint16_t address);
+    
     uint16_t fetch16(uint16_t address);
     
-    void write8(uint16_t address, uint8_t data, bool isDma = false);
+    void write8(uint16_t address, uint8_t data, bool isDma = false) {
+        writes++;
+        
+        if(uint8_t* page = writePages[address >> 8]) {
+            page[address & 0xFF] = data;
+            return;
+        }
+        
+        writeSlow(address, data, isDma);
+    }
+    
     void writeIO(uint16_t address, uint8_t data, bool isDma = false);
     
     void write16(uint16_t address, uint16_t data);
     
     void switchSpeed();
     void clear();
+    
+    /**
+     * Banks, speed switch, OAM DMAs and HDMA.
+     * The page tables aren't saved, call 'updatePages' after loading.
+     */
+    void serialize(Serializer& s);
+    
+    /**
+     * Refreshes 'romBankOffset' from the MBC,
+     * needs to be called after every bank switch.
+     */
+    void updateRomBanks();
+    
+    /**
+     * Rebuilds 'readPages' and 'writePages',
+     * needs to be called whenever the VRAM/WRAM bank,
+     * the boot ROM or the active DMAs change.
+     */
+    void updatePages();
 
     // C++ is being a bitch
-    static inline DMA isWithinRange(uint16_t start, uint16_t end, std::vector<DMA> dmas) {
-        for(auto dma : dmas) {
+    static inline DMA isWithinRange(uint16_t start, uint16_t end, const std::vector<DMA>& dmas) {
+        for(const auto& dma : dmas) {
             if(dma.source >= start || dma.source <= end) {
                 return dma;
             }
@@ -160,6 +208,44 @@ public:
     
     bool bootRomActive = false;
     
+    /**
+     * Where 0x0000-0x3FFF and 0x4000-0x7FFF,
+     * currently start in the ROM.
+     */
+    uint32_t romBankOffset[2] = { 0, 0x4000 };
+    
+    /**
+     * One pointer per 256 byte page, straight into ROM/VRAM/WRAM,
+     * or nullptr if that page has to take the slow path.
+     */
+    const uint8_t* readPages[0x100] = {};
+    uint8_t* writePages[0x100] = {};
+    
+    /**
+     * Called right before IO (0xFF00-0xFF7F) is read or written,
+     * so whoever batches up cycles can tick everything first.
+     */
+    using SyncCallback = std::function<void(bool write)>;
+    SyncCallback sync = [](bool) {};
+    
+    /**
+     * Sees every write the CPU makes (not the DMAs).
+     * While set, every write takes the slow path, call 'updatePages' after changing it.
+     */
+    using WriteHook = std::function<void(uint16_t address, uint8_t data)>;
+    WriteHook writeHook;
+    
+    // Every 'fetch8'/'write8', for benchmarking
+    uint64_t reads = 0;
+    uint64_t writes = 0;
+    
+    // SVBK, which bank is at 0xD000
+    uint8_t getWramBank() const { return wramBank; }
+    
+private:
+    uint8_t fetchSlow(uint16_t address, bool isDma);
+    void writeSlow(uint16_t address, uint8_t data, bool isDma);
+    
 private:
     uint8_t wramBank = 1;
     
@@ -227,5 +313,7 @@ public:
     
     APU& apu;
     
+    const Cartridge& cartridge;
+    
     std::vector<uint8_t> bootRom;
 };
@@ -0,0 +1,114 @@
+#include "RomImage.h"
+
+#include <fstream>
+#include <iostream>
+
+#include "../CPU/DecodeCache.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/**
+ * Maps the whole file read-only,
+ * returns nullptr if that didn't work out.
+ */
+static void* mapFile(const std::string& path, size_t& size) {
+#if defined(_WIN32)
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	
+	if(file == INVALID_HANDLE_VALUE)
+		return nullptr;
+	
+	LARGE_INTEGER fileSize;
+	void* view = nullptr;
+	
+	if(GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0) {
+		HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		
+		if(mapping) {
+			view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+			size = static_cast<size_t>(fileSize.QuadPart);
+			
+			// The view keeps the mapping alive
+			CloseHandle(mapping);
+		}
+	}
+	
+	CloseHandle(file);
+	
+	return view;
+#else
+	int fd = ::open(path.c_str(), O_RDONLY);
+	
+	if(fd < 0)
+		return nullptr;
+	
+	struct stat info;
+	void* view = nullptr;
+	
+	if(fstat(fd, &info) == 0 && info.st_size > 0) {
+		view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+		size = static_cast<size_t>(info.st_size);
+		
+		if(view == MAP_FAILED)
+			view = nullptr;
+	}
+	
+	// The mapping stays valid after closing
+	close(fd);
+	
+	return view;
+#endif
+}
+
+RomHandle RomImage::open(const std::string& path) {
+	std::shared_ptr<RomImage> image(new RomImage());
+	
+	if(void* view = mapFile(path, image->length)) {
+		image->mapping = view;
+		image->bytes = static_cast<const uint8_t*>(view);
+		image->decodeCache = std::make_unique<DecodeCache>(*image);
+		
+		return image;
+	}
+	
+	// Some filesystems can't be mapped, read it in instead
+	std::ifstream stream(path, std::ios::binary);
+	
+	if(!stream) {
+		std::cerr << "Cannot read from file: " << path << '\n';
+		return nullptr;
+	}
+	
+	std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+	
+	return fromBytes(std::move(bytes));
+}
+
+RomHandle RomImage::fromBytes(std::vector<uint8_t> bytes) {
+	std::shared_ptr<RomImage> image(new RomImage());
+	
+	image->storage = std::move(bytes);
+	image->bytes = image->storage.data();
+	image->length = image->storage.size();
+	image->decodeCache = std::make_unique<DecodeCache>(*image);
+	
+	return image;
+}
+
+RomImage::~RomImage() {
+	if(!mapping)
+		return;
+
+#if defined(_WIN32)
+	UnmapViewOfFile(mapping);
+#else
+	munmap(mapping, length);
+#endif
+}
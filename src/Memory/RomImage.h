@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * A ROM, read-only and shared by everything that runs it.
+ *
+ * Files are memory mapped where possible, so nothing is copied,
+ * and every GameBoy (and every MBC in it) made from the same image,
+ * points at the same pages, however many of them there are.
+ * The pre-decoded instructions live here too, and are shared the same way.
+ */
+
+class DecodeCache;
+class RomImage;
+
+using RomHandle = std::shared_ptr<const RomImage>;
+
+class RomImage {
+public:
+	// nullptr if the file can't be read
+	static RomHandle open(const std::string& path);
+	
+	// For ROMs that are already in memory
+	static RomHandle fromBytes(std::vector<uint8_t> bytes);
+	
+	~RomImage();
+	
+	RomImage(const RomImage&) = delete;
+	RomImage& operator=(const RomImage&) = delete;
+	
+	const uint8_t* data() const { return bytes; }
+	size_t size() const { return length; }
+	
+	uint8_t operator[](size_t index) const { return bytes[index]; }
+	
+	// False if it had to be read in instead
+	bool isMapped() const { return mapping != nullptr; }
+	
+	const DecodeCache& decoded() const { return *decodeCache; }
+
+private:
+	RomImage() = default;
+
+private:
+	const uint8_t* bytes = nullptr;
+	size_t length = 0;
+	
+	// Start of the view, for unmapping
+	void* mapping = nullptr;
+	
+	// When it's not mapped
+	std::vector<uint8_t> storage;
+	
+	std::unique_ptr<const DecodeCache> decodeCache;
+};
@@ -4,9 +4,15 @@
 #include <cstdint>
 #include <iostream>
 
+#include "../Utility/Serializer.h"
+
 WRAM::WRAM() {
     std::random_device rd;
-    std::mt19937 generator(rd());
+    randomize(rd());
+}
+
+void WRAM::randomize(uint32_t seed) {
+    std::mt19937 generator(seed);
     std::uniform_int_distribution<int> distribution(0, 255);
     
     for (auto& i : RAM) {
@@ -29,3 +35,7 @@ void WRAM::write8(uint16_t address, uint8_t data) {
     
     RAM[address] = data;
 }
+
+void WRAM::serialize(Serializer& s) {
+    s(RAM);
+}
@@ -1,14 +1,24 @@
 ﻿#pragma once
 #include <cstdint>
 
+class Serializer;
+
 // https://gbdev.io/pandocs/MBC1.html#00003fff--rom-bank-x0-read-only
 class WRAM {
 public:
     WRAM();
     
+    // Garbage, like on power up, but the same garbage for the same seed
+    void randomize(uint32_t seed);
+    
     uint8_t fetch8(uint16_t address);
     void write8(uint16_t address, uint8_t data);
     
+    // Used by the MMU's page table
+    uint8_t* data() { return RAM; }
+    
+    void serialize(Serializer& s);
+    
 private:
     uint8_t RAM[32 * 1024] = { 0 }; // 8 KB
 };
@@ -6,6 +6,7 @@
 
 #include "PPU.h"
 #include "../Utility/Bitwise.h"
+#include "../Utility/Serializer.h"
 
 uint8_t LCDC::fetch8(uint16_t address) {
 	if(address == 0xFF40) {
@@ -13,7 +14,8 @@ uint8_t LCDC::fetch8(uint16_t address) {
 	} else if(address == 0xFF41) {
 		// https://gbdev.io/pandocs/STAT.html#ff41--stat-lcd-status
 		
-		return 0x80 | (lycInc ? 0x40 : 0) | (mode2 ? 0x20 : 0) | (mode1 ? 0x10 : 0) | (mode0 ? 0x08 : 0) | ((LY == LYC) ? 0x04 : 0) | PPU::mode;
+		// Bits 0-1 (PPU mode) are owned by the PPU, the MMU ORs them in
+		return 0x80 | (lycInc ? 0x40 : 0) | (mode2 ? 0x20 : 0) | (mode1 ? 0x10 : 0) | (mode0 ? 0x08 : 0) | ((LY == LYC) ? 0x04 : 0);
 	} else if(address == 0xFF42) {
 		// $FF42	SCY	Viewport Y position	R/W	All
 		return SCY;
@@ -142,3 +144,29 @@ void LCDC::write8(uint16_t address, uint8_t data) {
 		bgWindowEnabled = check_bit(data, 0);
 	}
 }
+
+void LCDC::serialize(Serializer& s) {
+	s(interrupt);
+	s(LCDCControl);
+	
+	s(lycInc);
+	s(mode0);
+	s(mode1);
+	s(mode2);
+	
+	s(SCY);
+	s(SCX);
+	s(WY);
+	s(WX);
+	s(LY);
+	s(LYC);
+	
+	s(enable);
+	s(windowTileMapArea);
+	s(windowEnabled);
+	s(bgWinTileDataArea);
+	s(bgTileMapArea);
+	s(objSize);
+	s(objEnabled);
+	s(bgWindowEnabled);
+}
@@ -1,6 +1,8 @@
 ﻿#pragma once
 #include <cstdint>
 
+class Serializer;
+
 // https://gbdev.io/pandocs/LCDC.html
 
 /**
@@ -14,6 +16,8 @@ public:
 	uint8_t fetch8(uint16_t address);
 	void write8(uint16_t address, uint8_t data);
 	
+	void serialize(Serializer& s);
+	
 public:
 	uint8_t interrupt = 0;
 	
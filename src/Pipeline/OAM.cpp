@@ -1,9 +1,50 @@
 ﻿#include "OAM.h"
 
+#include "../Utility/Serializer.h"
+
 uint8_t OAM::fetch8(uint16_t address) {
 	return RAM[address - 0xFE00];
 }
 
 void OAM::write8(uint16_t address, uint8_t data) {
+	// Only Y decides which lines an object is on
+	if((address & 0x03) == 0 && RAM[address] != data)
+		bucketsDirty = true;
+	
 	RAM[address] = data;
 }
+
+void OAM::serialize(Serializer& s) {
+	s.bytes(RAM, 0x100);
+	
+	if(s.isLoading())
+		bucketsDirty = true;
+}
+
+const uint8_t* OAM::objectsOn(uint8_t line, uint8_t& count) {
+	if(bucketsDirty)
+		buildBuckets();
+	
+	count = bucketSize[line];
+	return bucket[line];
+}
+
+void OAM::buildBuckets() {
+	for(uint8_t& size : bucketSize) {
+		size = 0;
+	}
+	
+	for(uint8_t i = 0; i < OBJECTS; i++) {
+		// https://gbdev.io/pandocs/OAM.html#byte-0--y-position
+		int16_t top = static_cast<int16_t>(RAM[i * 4] - 16);
+		
+		int16_t first = top < 0 ? 0 : top;
+		int16_t last = top + 16 > LINES ? LINES : top + 16;
+		
+		for(int16_t line = first; line < last; line++) {
+			bucket[line][bucketSize[line]++] = i;
+		}
+	}
+	
+	bucketsDirty = false;
+}
@@ -1,12 +1,40 @@
 ﻿#pragma once
 #include <cstdint>
 
+class Serializer;
+
 // https://gbdev.io/pandocs/OAM.html
 
 class OAM {
 public:
+	static constexpr uint8_t OBJECTS = 40;
+	static constexpr uint8_t LINES = 144;
+	
 	uint8_t fetch8(uint16_t address);
 	void write8(uint16_t address, uint8_t data);
+	
+	// FE00-FEFF
+	void serialize(Serializer& s);
+	
+	/**
+	 * Objects that could be on 'line' (0-143), in OAM order,
+	 * checked as if every object was 16 lines tall, so 8x8 ones still need a Y check.
+	 *
+	 * The buckets are only rebuilt after a Y position changed,
+	 * so most lines are just a lookup, and lines without objects are free.
+	 */
+	const uint8_t* objectsOn(uint8_t line, uint8_t& count);
+	
+	// The 4 bytes of object 'index', Y, X, tile, flags
+	const uint8_t* object(uint8_t index) const { return RAM + index * 4; }
+	
+private:
+	void buildBuckets();
+	
 private:
 	uint8_t RAM[0x2000] = { 0 };
+	
+	uint8_t bucket[LINES][OBJECTS] = { { 0 } };
+	uint8_t bucketSize[LINES] = { 0 };
+	bool bucketsDirty = true;
 };
@@ -2,19 +2,19 @@
 
 #include <algorithm>
 #include <iostream>
+#include <vector>
 
 #include "LCDC.h"
-#include "SDL.h"
+#include "OAM.h"
 #include "VRAM.h"
 #include "../Memory/Cartridge.h"
 
 #include "../Memory/MMU.h"
 #include "../Utility/Bitwise.h"
+#include "../Utility/Serializer.h"
 
-constexpr int WIDTH = 160;
-constexpr int HEIGHT = 144;
-
-PPU::PPUMode PPU::mode = PPU::HBlank;
+constexpr int WIDTH = PPU::SCREEN_WIDTH;
+constexpr int HEIGHT = PPU::SCREEN_HEIGHT;
 
 void PPU::tick(int cycles = 4) {
 	if(!lcdc.enable)
@@ -57,12 +57,39 @@ void PPU::tick(int cycles = 4) {
 	}
 }
 
+uint32_t PPU::cyclesUntilEvent() const {
+	if(!lcdc.enable)
+		return UINT32_MAX;
+	
+	// Next line
+	uint32_t next = 456;
+	
+	if(lcdc.LY < 144) {
+		// Same thresholds as in 'tick'
+		PPUMode expected = currentDot <= 80 ? OAMScan : (currentDot <= 80 + 172 ? VRAMTransfer : HBlank);
+		
+		// Gets fixed on the next tick
+		if(mode != expected)
+			return 1;
+		
+		if(currentDot <= 80) next = 81;
+		else if(currentDot <= 80 + 172) next = 80 + 172 + 1;
+	}
+	
+	return next > currentDot ? next - currentDot : 1;
+}
+
 void PPU::updateMode(PPUMode mode) {
 	this->mode = mode;
 	
 	switch(this->mode) {
 		case HBlank: {
-			drawScanline();
+			if(render)
+				drawScanline();
+			
+			// Still counts window lines, the next frame that's drawn can start halfway down the screen
+			else if(lcdc.windowEnabled && drawWindow && lcdc.WX <= 166)
+				winLineCounter++;
 			
 			if(lcdc.mode0) {
 				interrupt |= 0x02;
@@ -80,10 +107,7 @@ void PPU::updateMode(PPUMode mode) {
 				interrupt |= 0x02;
 			}
 			
-			SDL_UpdateTexture(texture, nullptr, pixels, pitch);
-			SDL_RenderPresent(renderer);
-			//SDL_RenderCopy(renderer, texture, nullptr, nullptr);
-			//SDL_RenderPresent(renderer);
+			// The frontend uploads 'pixels' once per frame
 			
 			break;
 		}
@@ -109,15 +133,22 @@ void PPU::updateMode(PPUMode mode) {
 }
 
 void PPU::drawScanline() {
-	for (BGPriority& i : bgPriority) {
-		i = Zero;
-	}
+	bool background = drawBackground();
 	
-	drawBackground();
+	scanline.clearObjects();
 	drawSprites();
+	
+	const uint32_t* colors = cartridge.mode == Color ? &CGBColors[0][0][0] : &DMGColors[0][0][0];
+	uint32_t* line = pixels + lcdc.LY * WIDTH;
+	
+	if(simd) {
+		scanline.compose(colors, line, background);
+	} else {
+		scanline.composeScalar(colors, line, background);
+	}
 }
 
-void PPU::drawBackground() {
+bool PPU::drawBackground() {
     uint8_t LY  = lcdc.LY;//mmu.fetch8(0xFF44);
 	
 	uint8_t SCY = lcdc.SCY;//mmu.fetch8(0xFF42);
@@ -128,58 +159,54 @@ void PPU::drawBackground() {
 	
 	uint16_t tileWinMapBase = lcdc.windowTileMapArea  ? 0x9C00 : 0x9800;
 	uint16_t tileBGMapBase  = lcdc.bgTileMapArea      ? 0x9C00 : 0x9800;
-	uint16_t tileBGMap      = lcdc.bgWinTileDataArea  ? 0x8000 : 0x8800;
 	
 	//bool drawWindow = lcdc.windowEnabled && LY >= WY && WX <= 166;
 	
 	if(!lcdc.windowEnabled && !lcdc.bgWindowEnabled/*????*/)
-		return;
+		return false;
 	
 	if(lcdc.windowEnabled && drawWindow && WX <= 166) {
 		winLineCounter++;
 	}
 	
+	// Where the window starts on this line, the background is left of it
+	uint32_t windowX = WIDTH;
+	
+	if(lcdc.windowEnabled && drawWindow && lcdc.WY < 140)
+		windowX = WX < 7 ? 0 : std::min<uint32_t>(WX - 7, WIDTH);
+	
 	uint8_t bgY = SCY + LY;
 	
-	// 160 = Screen width
-	for(size_t x = 0; x < 160; x++) {
-		int32_t winX = drawWindow ? -(static_cast<int32_t>(WX) - 7) + static_cast<int32_t>(x) : -1;
-		uint8_t bgX = static_cast<uint8_t>(x) + SCX;
-		
-		uint16_t tilemapAddr;
-		uint16_t tileX, tileY;
-		uint8_t pY, pX;
-		
-        if(lcdc.windowEnabled && drawWindow && winX >= 0 && lcdc.WY < 140) {
-			tilemapAddr = tileWinMapBase;
-			
-			tileY = static_cast<uint16_t>((winLineCounter - 1)) >> 3;
-			tileX = static_cast<uint16_t>(winX) >> 3;
-			
-			pY = (winLineCounter - 1) & 0x07; // % 8
-			pX = static_cast<uint8_t>(winX) & 0x07; // % 8
-		} else {
-			tilemapAddr = tileBGMapBase;
-			
-			tileY = (bgY >> 3) & 31;
-			tileX = (bgX >> 3) & 31;
-			
-			pY = bgY & 0x07;
-			pX = (bgX & 0x07);
-		}
+	drawTiles(0, windowX, tileBGMapBase, SCX, bgY);
+	
+	// With WX < 7 the window's first few pixels are off screen
+	if(windowX < WIDTH)
+		drawTiles(windowX, WIDTH, tileWinMapBase, static_cast<uint8_t>(windowX + 7 - WX), static_cast<uint8_t>(winLineCounter - 1));
+	
+	return true;
+}
+
+void PPU::drawTiles(uint32_t from, uint32_t to, uint16_t tilemapAddr, uint8_t u, uint8_t v) {
+	uint16_t tileY = (v >> 3) & 31;
+	uint8_t pY = v & 0x07; // % 8
+	
+	for(uint32_t x = from; x < to;) {
+		uint16_t tileX = (u >> 3) & 31;
+		uint16_t mapAddr = (tilemapAddr + tileY * 32 + tileX) & 0x1FFF;
 		
-		//uint8_t tileID = mmu.fetch8(tilemapAddr + tileY * 32 + tileX);
-		uint8_t tileID = mmu.vram.RAM[(tilemapAddr + tileY * 32 + tileX) & 0x1FFF];
+		uint8_t tileID = vram.RAM[mapAddr];
 		
 		// https://gbdev.io/pandocs/Tile_Maps.html#bg-map-attributes-cgb-mode-only
 		bool priority = false;
 		bool yFlip = false;
 		bool xFlip = false;
-		bool bank = false;
-		uint8_t colorPalette = 0;
+		uint8_t bank = 0;
+		
+		// 'palette * 4', DMG only has the one
+		uint8_t paletteBase = 0;
 		
-		if(Cartridge::mode == Color) {
-			uint8_t flags = mmu.vram.RAM[0x2000 + ((tilemapAddr + tileY * 32 + tileX) & 0x1FFF)];
+		if(cartridge.mode == Color) {
+			uint8_t flags = vram.RAM[0x2000 + mapAddr];
 			
 			/**
 			 * Bit 7 - Priority
@@ -199,47 +226,27 @@ void PPU::drawBackground() {
 			bank = check_bit(flags, 3);
 			
 			// Bit 2 - 0 - Colour pallete
-			colorPalette = flags & 0b00000111;
+			paletteBase = (flags & 0b00000111) * 4;
 		}
 		
-		uint16_t offset;
-		
 		// https://gbdev.io/pandocs/Tile_Data.html?highlight=signed#vram-tile-data
+		uint16_t tile = lcdc.bgWinTileDataArea ? tileID : static_cast<uint16_t>(256 + static_cast<int8_t>(tileID));
 		
-		if(tileBGMap == 0x8000) {
-			offset = tileBGMap + (static_cast<uint16_t>(tileID)) * 16;
-		} else {
-			offset = tileBGMap + static_cast<uint16_t>(static_cast<int16_t>(static_cast<int8_t>(tileID) + 128)) * 16;
-		}
-		
-		// Tiles are flipped by default
-		pX = xFlip ? pX : 7 - pX;
+		const uint8_t* row = vram.tiles.row(bank, tile, yFlip ? 7 - pY : pY, xFlip);
 		
-		uint16_t address = yFlip ? offset + (14 - (pY * 2)) : offset + (pY * 2);
+		// The rest of this tile, or up to 'to'
+		uint8_t pX = u & 0x07;
+		uint32_t count = std::min<uint32_t>(8 - pX, to - x);
 		
-		uint8_t b0 = (bank && Cartridge::mode == Color) ? mmu.vram.RAM[(address & 0x1FFF) + 0x2000]       : mmu.vram.RAM[(address & 0x1FFF)];
-		uint8_t b1 = (bank && Cartridge::mode == Color) ? mmu.vram.RAM[((address & 0x1FFF) + 0x2000) + 1] : mmu.vram.RAM[(address & 0x1FFF) + 1];
-		
-		uint8_t pixel = static_cast<uint8_t>((b0 >> pX) & 1) | static_cast<uint8_t>(((b1 >> pX) & 1) << 1);
-		bgPriority[x] = pixel == 0 ? Zero : (priority ? Priority : None);
-		//bgPriority[x] = priority ? Priority : (pixel == 0 ? Zero : None);
-		
-		if(Cartridge::mode == DMG) {
-			uint8_t pixelColor = (bgp >> (pixel * 2)) & 0x03;
-			
-			updatePixel(static_cast<uint8_t>(x), LY, paletteIndexToColor(pixelColor));
-		} else if(Cartridge::mode == Color) {
-			uint8_t lsb = CBGPalette[(colorPalette * 8) + (pixel * 2)];
-			uint8_t msb = CBGPalette[(colorPalette * 8) + (pixel * 2) + 1];
-			
-			uint16_t color = static_cast<uint16_t>(msb << 8) | lsb;
+		for(uint32_t i = 0; i < count; i++) {
+			uint8_t pixel = row[pX + i];
 			
-			uint32_t s = convertRGB555ToSDL(color);
-			
-			updatePixel(static_cast<uint8_t>(x), LY, s);
+			scanline.bg[x + i] = paletteBase | pixel;
+			scanline.bgOver[x + i] = priority && pixel != 0 ? 0xFF : 0x00;
 		}
 		
-		//SDL_RenderPresent(renderer);
+		x += count;
+		u = static_cast<uint8_t>(u + count);
 	}
 }
 
@@ -252,79 +259,81 @@ void PPU::drawSprites() {
 	uint8_t LY = lcdc.LY; //mmu.fetch8(0xFF44);
 	uint8_t spriteHeight = lcdc.objSize ? 16 : 8;
 	
-	// TODO; Move this outta here
+	/**
+	 * The PPU can't read OAM while a DMA is writing to it,
+	 * https://gbdev.io/pandocs/OAM_DMA_Transfer.html
+	 */
+	if(!mmu.dmas.empty())
+		return;
+	
 	struct Sprite {
-		uint8_t index = 0;
-		int16_t x = 0, y = 0;
-		
-		Sprite() : index(0), x(0), y(0) {}
-		Sprite(uint8_t index, int16_t x, int16_t y) : index(index), x(x), y(y) {}
+		uint8_t index;
+		int16_t x, y;
 	};
 	
-	std::vector<Sprite> spriteBuffer;
+	// In drawing order, the one drawn last wins
+	Sprite spriteBuffer[10];
+	uint8_t spriteCount = 0;
+	
+	uint8_t candidateCount = 0;
+	const uint8_t* candidates = oam.objectsOn(LY, candidateCount);
+	
+	const bool byX = cartridge.mode != Color || opri;
 	
 	/**
 	 * According to (https://gbdev.io/pandocs/OAM.html),
 	 * The PPU can render up to 40 moveble objects,
 	 * but only 10 objects can be displayed per scanline.
 	 */
-	for(uint8_t i = 0; i < 40; i++) {
-		// 0xFE00 -> OAM
-		uint16_t spriteAdr = 0xFE00 + i * 4;
+	for(uint8_t i = 0; i < candidateCount && spriteCount < 10; i++) {
+		Sprite sprite;
+		sprite.index = candidates[i];
+		
+		const uint8_t* object = oam.object(sprite.index);
 		
-		int16_t spriteY = static_cast<int16_t>(mmu.fetch8(spriteAdr + 0) - 16);
+		// Already known to start at or above LY
+		sprite.y = static_cast<int16_t>(object[0] - 16);
 		
-		if (LY < spriteY || LY >= spriteY + spriteHeight) {
+		if (LY >= sprite.y + spriteHeight) {
 			continue;
 		}
 		
-		int16_t spriteX = static_cast<int16_t>(mmu.fetch8(spriteAdr + 1) - 8);
+		sprite.x = static_cast<int16_t>(object[1] - 8);
 		
-		if (spriteX < -7 || spriteX >= 160) {
+		if (sprite.x < -7 || sprite.x >= 160) {
 			continue;
 		}
 		
-		spriteBuffer.emplace_back(i, spriteX, spriteY);
-		if (spriteBuffer.size() >= 10) break;
-	}
-	
-	if (spriteBuffer.empty())
-		return;
-	
-	// https://gbdev.io/pandocs/OAM.html#drawing-priority
-	
-	if(Cartridge::mode == Color) {
-	//if(opri) {
-		// CGB Mode
-		std::stable_sort(spriteBuffer.begin(), spriteBuffer.end(), [](const Sprite& a, const Sprite& b) {
-			// Order by OAM position
-			return a.index > b.index;
-		});
-	} else {
-		// DMG Mode
-		std::stable_sort(spriteBuffer.begin(), spriteBuffer.end(), [](const Sprite& a, const Sprite& b) {
-			// Order by x prioritization
-			if (a.x != b.x) {
-				return a.x > b.x;
-			}
-			
-			// Order by OAM position
-			return a.index > b.index;
-		});
+		/**
+		 * https://gbdev.io/pandocs/OAM.html#drawing-priority
+		 *
+		 * Candidates come in OAM order, so this one has the highest index so far,
+		 * it goes in front of everything it loses to.
+		 *
+		 * CGB - Only OAM position, so always first
+		 * DMG - Smaller X wins, then OAM position
+		 *
+		 * CGB games can ask for the DMG rule through OPRI.
+		 */
+		uint8_t j = spriteCount++;
+		
+		while(j > 0 && (!byX || spriteBuffer[j - 1].x <= sprite.x)) {
+			spriteBuffer[j] = spriteBuffer[j - 1];
+			j--;
+		}
+		
+		spriteBuffer[j] = sprite;
 	}
 	
-	for (auto sprite : spriteBuffer) {
-		if (sprite.x < -7 || sprite.x >= 160)
-			continue;
-		
-		// 0xFE00 -> OAM
-		uint16_t spriteAddr = 0xFE00 + sprite.index * 4;
+	for(uint8_t i = 0; i < spriteCount; i++) {
+		const Sprite& sprite = spriteBuffer[i];
+		const uint8_t* object = oam.object(sprite.index);
 		
 		// https://gbdev.io/pandocs/OAM.html#byte-3--attributesflags
-		uint16_t tileIndex = (mmu.fetch8(spriteAddr + 2) & (spriteHeight == 16 ? 0xFE : 0xFF));
+		uint16_t tileIndex = (object[2] & (spriteHeight == 16 ? 0xFE : 0xFF));
 		
 		// https://gbdev.io/pandocs/OAM.html#byte-3--attributesflags
-		uint8_t flags = mmu.fetch8(spriteAddr + 3);
+		uint8_t flags = object[3];
 		
 		/**
 		 * 0 - NO
@@ -373,10 +382,10 @@ void PPU::drawSprites() {
 		 *
 		 * Objects always use “$8000 addressing”, but the BG and Window can use either mode, controlled by LCDC bit 4.
 		 */
-		uint16_t tileAddr = 0x8000 + tileIndex * 16 + tileY * 2;
+		const uint8_t* row = vram.tiles.row(bank && cartridge.mode == Color, tileIndex + (tileY >> 3), tileY & 0x07, flipX);
 		
-		uint8_t b0 = (bank && Cartridge::mode == Color) ? mmu.vram.RAM[((tileAddr & 0x1FFF) + 0x2000) + 0] : mmu.vram.RAM[(tileAddr & 0x1FFF) + 0];
-		uint8_t b1 = (bank && Cartridge::mode == Color) ? mmu.vram.RAM[((tileAddr & 0x1FFF) + 0x2000) + 1] : mmu.vram.RAM[(tileAddr & 0x1FFF) + 1];
+		// OBJ half of the color table
+		uint8_t paletteBase = static_cast<uint8_t>(32 + (cartridge.mode == DMG ? dmgPallete : palette) * 4);
 		
 		/**
 		 * From what I understand is that the,
@@ -385,48 +394,30 @@ void PPU::drawSprites() {
 		 * So 8 here is the width of every sprite.
 		 * As only the height changes from 8-16,
 		 * I don't need any extra checks
+		 *
+		 * Only the part that's on screen.
 		 */
-		for(uint16_t x = 0; x < 8; x++) {
-			if ((sprite.x + x) < 0 || sprite.x + x >= 160)
-				continue;
-			
-			// Priority 1 - BG and Window colours 1–3 are drawn over this OBJ
-			
-			if(Cartridge::mode == DMG) {
-				if(priority && bgPriority[sprite.x + x] != Zero) {
-					continue;
-				}
-			} else if(Cartridge::mode == Color) {
-				if (lcdc.enable &&
-					(bgPriority[sprite.x + x] == Priority || (priority && bgPriority[sprite.x + x] != Zero))) {
-					continue;
-				}
-			}
-			
-			int16_t pX = static_cast<int16_t>(flipX ? x : static_cast<int16_t>(7 - x));
+		int16_t startX = std::max<int16_t>(0, static_cast<int16_t>(-sprite.x));
+		int16_t endX = std::min<int16_t>(8, static_cast<int16_t>(WIDTH - sprite.x));
+		
+		for(int16_t x = startX; x < endX; x++) {
+			uint32_t screenX = sprite.x + x;
 			
-			// Just copied this from 'drawBackground'
-			uint8_t pixel = static_cast<uint8_t>((b0 >> pX) & 1) | static_cast<uint8_t>(((b1 >> pX) & 1) << 1);
+			// Already flipped
+			uint8_t pixel = row[x];
 			
 			if(pixel == 0)
 				continue;
 			
-			uint32_t color = 0;
-			
-			if(Cartridge::mode == DMG) {
-				uint8_t pixelColor = dmgPallete ? OBJ1Palette[pixel] : OBJ0Palette[pixel];
-				
-				color = paletteIndexToColor(pixelColor);
-			} else if(Cartridge::mode == Color) {
-				uint8_t lsb = COBJPalette[(palette * 8) + (pixel * 2)];
-				uint8_t msb = COBJPalette[(palette * 8) + (pixel * 2) + 1];
-				
-				uint16_t rgb = static_cast<uint16_t>(msb << 8) | lsb;
-				
-				color = convertRGB555ToSDL(rgb);
-			}
+			/**
+			 * Priority 1 - BG and Window colours 1–3 are drawn over this OBJ
+			 *
+			 * That's left to the compositor, which one shows depends on the BG pixel.
+			 */
+			scanline.objAll[screenX] = paletteBase | pixel;
 			
-			updatePixel(sprite.x + x, LY, color);
+			if(!priority)
+				scanline.objFront[screenX] = paletteBase | pixel;
 		}
 	}
 }
@@ -445,7 +436,7 @@ uint8_t PPU::fetch8(uint16_t address) {
 	} else if(address == 0xFF68) {
 		// https://gbdev.io/pandocs/Palettes.html#ff68--bcpsbgpi-cgb-mode-only-background-color-palette-specification--background-palette-index
 		
-		if(Cartridge::mode != Color) return 0xFF;
+		if(cartridge.mode != Color) return 0xFF;
 		
 		uint8_t data = 0;
 		
@@ -456,7 +447,7 @@ uint8_t PPU::fetch8(uint16_t address) {
 	} else if(address == 0xFF69) {
 		// https://gbdev.io/pandocs/Palettes.html#ff69--bcpdbgpd-cgb-mode-only-background-color-palette-data--background-palette-data
 		
-		if(Cartridge::mode != Color) return 0xFF;
+		if(cartridge.mode != Color) return 0xFF;
 		
 		if(mode == VRAMTransfer) {
 			return 0xFF;
@@ -470,7 +461,7 @@ uint8_t PPU::fetch8(uint16_t address) {
 		
 		return data;
 	} else if(address == 0xFF6A) {
-		if(Cartridge::mode != Color) return 0xFF;
+		if(cartridge.mode != Color) return 0xFF;
 		
 		uint8_t data = 0;
 		
@@ -479,7 +470,7 @@ uint8_t PPU::fetch8(uint16_t address) {
 		
 		return data;
 	} else if(address == 0xFF6B) {
-		if(Cartridge::mode != Color) return 0xFF;
+		if(cartridge.mode != Color) return 0xFF;
 		
 		if(mode == VRAMTransfer) {
 			return 0xFF;
@@ -495,7 +486,7 @@ uint8_t PPU::fetch8(uint16_t address) {
 	} else if(address == 0xFF6C) {
 		// https://gbdev.io/pandocs/CGB_Registers.html#ff6c--opri-cgb-mode-only-object-priority-mode
 		
-		if(Cartridge::mode != Color) return 0xFF;
+		if(cartridge.mode != Color) return 0xFF;
         
 		return opri;
 	}
@@ -516,6 +507,7 @@ void PPU::write8(uint16_t address, uint8_t data) {
 			BGPalette[i] = (bgp >> (i * 2)) & 0x03;
 		}
 		
+		updateDMGColors();
 	} else if(address == 0xFF48 || address == 0xFF49) {
 		// https://gbdev.io/pandocs/Palettes.html#ff48ff49--obp0-obp1-non-cgb-mode-only-obj-palette-0-1-data
 		
@@ -528,10 +520,12 @@ void PPU::write8(uint16_t address, uint8_t data) {
 				OBJ1Palette[i] = (data >> (i * 2)) & 0x03;
 			}
 		}
+		
+		updateDMGColors();
 	} else if(address == 0xFF68) {
 		// https://gbdev.io/pandocs/Palettes.html#ff68--bcpsbgpi-cgb-mode-only-background-color-palette-specification--background-palette-index
 		
-		if(Cartridge::mode != Color) return;
+		if(cartridge.mode != Color) return;
 		
 		/**
 		 * Bit 7 - Auto-increment
@@ -545,20 +539,21 @@ void PPU::write8(uint16_t address, uint8_t data) {
 		bgIndex = data & 0b00111111;
 	} else if(address == 0xFF69) {
 		// https://gbdev.io/pandocs/Palettes.html#ff69--bcpdbgpd-cgb-mode-only-background-color-palette-data--background-palette-data
-		if(Cartridge::mode != Color) return;
+		if(cartridge.mode != Color) return;
 		
 		if(mode == VRAMTransfer) {
 			return;
 		}
 		
 		CBGPalette[bgIndex] = data;
+		updateCGBColor(false, bgIndex);
 		
 		if(autoIncrementBG) {
 			bgIndex = (bgIndex + 1) & 0x3F; // Keep in range of 0-63
 		}
 	} else if(address == 0xFF6A) {
 		// https://gbdev.io/pandocs/Palettes.html#ff6aff6b--ocpsobpi-ocpdobpd-cgb-mode-only-obj-color-palette-specification--obj-palette-index-obj-color-palette-data--obj-palette-data
-		if(Cartridge::mode != Color) return;
+		if(cartridge.mode != Color) return;
 		
 		// Bit 7 - Auto-increment
 		autoIncrementOBJ = check_bit(data, 7);
@@ -567,20 +562,21 @@ void PPU::write8(uint16_t address, uint8_t data) {
 		objIndex = data & 0b00111111;
 	} else if(address == 0xFF6B) {
 		// https://gbdev.io/pandocs/Palettes.html#ff6aff6b--ocpsobpi-ocpdobpd-cgb-mode-only-obj-color-palette-specification--obj-palette-index-obj-color-palette-data--obj-palette-data
-		if(Cartridge::mode != Color) return;
+		if(cartridge.mode != Color) return;
 		
 		if(mode == VRAMTransfer) {
 			return;
 		}
 		
 		COBJPalette[objIndex] = data;
+		updateCGBColor(true, objIndex);
 		
 		if(autoIncrementOBJ) {
 			objIndex = (objIndex + 1) & 0x3F; // Keep in range of 0-63
 		}
 	} else if(address == 0xFF6C) {
 		// https://gbdev.io/pandocs/CGB_Registers.html#ff6c--opri-cgb-mode-only-object-priority-mode
-		if(Cartridge::mode != Color) return;
+		if(cartridge.mode != Color) return;
 		
 		/**
 		 * Bit 0 - Priority mode
@@ -592,145 +588,79 @@ void PPU::write8(uint16_t address, uint8_t data) {
 	}
 }
 
-void PPU::checkLYCInterrupt() {
-	if(lcdc.lycInc && lcdc.LY == lcdc.LYC) {
-		interrupt |= 0x02;
+void PPU::updateDMGColors() {
+	for(uint8_t i = 0; i < 4; i++) {
+		DMGColors[0][0][i] = paletteIndexToColor(BGPalette[i]);
+		DMGColors[1][0][i] = paletteIndexToColor(OBJ0Palette[i]);
+		DMGColors[1][1][i] = paletteIndexToColor(OBJ1Palette[i]);
 	}
 }
 
-void PPU::createWindow() {
-    
-	// Decide GL+GLSL versions
-#if defined(IMGUI_IMPL_OPENGL_ES2)
-	// GL ES 2.0 + GLSL 100
-	const char* glsl_version = "#version 100";
-	SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS, 0);
-	SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_ES);
-	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 2);
-	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 0);
-#elif defined(__APPLE__)
-	// GL 3.2 Core + GLSL 150
-	const char* glsl_version = "#version 150";
-	SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS, SDL_GL_CONTEXT_FORWARD_COMPATIBLE_FLAG); // Always required on Mac
-	SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
-	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
-	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 2);
-#else
-	// GL 3.0 + GLSL 130
-	const char* glsl_version = "#version 130";
-	SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS, 0);
-	SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
-	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
-	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 0);
-#endif
-
-	// From 2.0.18: Enable native IME.
-#ifdef SDL_HINT_IME_SHOW_UI
-	SDL_SetHint(SDL_HINT_IME_SHOW_UI, "1");
-#endif
-	
-	SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
-	SDL_GL_SetAttribute(SDL_GL_DEPTH_SIZE, 24);
-	SDL_GL_SetAttribute(SDL_GL_STENCIL_SIZE, 8);
-	
-	SDL_WindowFlags window_flags = (SDL_WindowFlags)(SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE | SDL_WINDOW_ALLOW_HIGHDPI);
-	
-    //window = SDL_CreateWindow("Game Boy", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
-    //    WIDTH * 6, HEIGHT * 6, window_flags);
-	
-    SDL_CreateWindowAndRenderer(WIDTH * 6, HEIGHT * 6, window_flags, &window, &renderer);
-    
-    if (window == nullptr) {
-        std::cerr << "Window could not be created SDL_Error: " << SDL_GetError() << '\n';
-        return;
-    }
-	
-    sdl_context = SDL_GL_CreateContext(window);
-    if (sdl_context == nullptr) {
-        std::cerr << "OpenGL context could not be created SDL_Error: " << SDL_GetError() << '\n';
-        return;
-    }
-	
-	SDL_GL_MakeCurrent(window, sdl_context);
-	SDL_GL_SetSwapInterval(1); // Enable vsync
-    
-    //renderer = SDL_CreateRenderer(window, -1, /*SDL_RENDERER_PRESENTVSYNC | SDL_RENDERER_ACCELERATED*/SDL_RENDERER_SOFTWARE);
-    //renderer = SDL_CreateRenderer(window, -1, 0);
-    if(renderer == nullptr) {
-        std::cerr << "ig not?\n";
-    }
-
-	surface = SDL_GetWindowSurface(window);
-	if (!surface) {
-		std::cerr << "SDL_CreateRGBSurface Error: " << SDL_GetError() << '\n';
-	}
-	
-	texture = createTexture(WIDTH, HEIGHT);
+void PPU::updateCGBColor(bool obj, uint8_t index) {
+	const uint8_t* palette = obj ? COBJPalette : CBGPalette;
 	
-	pixels = nullptr;
-	pitch = 0;
+	// Little endian, both bytes of the color
+	uint8_t lsb = palette[index & 0x3E];
+	uint8_t msb = palette[(index & 0x3E) + 1];
 	
-	if (SDL_LockTexture(texture, nullptr, reinterpret_cast<void**>(&pixels), &pitch) != 0) {
-		std::cerr << "Failed to lock texture: " << SDL_GetError() << '\n';
-		//throw std::runtime_error("Failed to lock texture");
-		//return;
-	}
-    
-	// Unlock the texture
-	SDL_UnlockTexture(texture);
+	uint32_t color = rgb555[(static_cast<uint16_t>(msb << 8) | lsb) & 0x7FFF];
 	
-	/*for(int x = 0; x < surface->w; x++) {
-		for(int y = 0; y < surface->h; y++) {
-			setPixel(x, y, 0xFFFF0000);
-		}
-	}*/
-	
-	//SDL_RenderPresent(renderer);
-    
-    std::cerr << "Main window created successfully\n";
+	CGBColors[obj][index >> 3][(index >> 1) & 0x03] = color;
 }
 
-void PPU::updatePixel(uint32_t x, uint32_t y, uint32_t color) {
-	float scale = 1;
+void PPU::setColorCorrection(ColorCorrection correction) {
+	colorCorrection = correction;
+	rgb555 = colorTable(correction);
 	
-	int startX = static_cast<int>(x * scale);
-	int startY = static_cast<int>(y * scale);
-	int endX = static_cast<int>((x + 1) * scale);
-	int endY = static_cast<int>((y + 1) * scale);
+	updateDMGColors();
 	
-	for(int nx = startX; nx < endX; nx++) {
-		for(int ny = startY; ny < endY; ny++) {
-			setPixel(nx, ny, color);
-		}
+	for(uint8_t i = 0; i < 64; i += 2) {
+		updateCGBColor(false, i);
+		updateCGBColor(true, i);
 	}
-	
-	//setPixel(x, y, color);
-	
-	/*SDL_RenderCopy(renderer, mainTexture, nullptr, nullptr);
-	
-	SDL_DestroyTexture(mainTexture);*/
-	//SDL_FreeSurface(surface);
 }
 
-void PPU::setPixel(uint32_t x, uint32_t y, uint32_t color) {
-	if (x < 0 || y < 0 || x >= static_cast<uint32_t>(surface->w) || y >= static_cast<uint32_t>(surface->h)) {
-		return;
-	}
-	
-	if (SDL_MUSTLOCK(surface)) {
-		if (SDL_LockSurface(surface) != 0) {
-			// Handle error if locking fails
-			std::cerr << "Failed to lock surface: " << SDL_GetError() << std::endl;
-			return;
+const uint32_t* PPU::colorTable(ColorCorrection correction) {
+	auto build = [](ColorCorrection correction) {
+		std::vector<uint32_t> table(0x8000);
+		
+		for(uint32_t color = 0; color < table.size(); color++) {
+			uint32_t r = (color >> 0) & 0x1F;         // 0-4   - Red
+			uint32_t g = (color >> 5) & 0x1F;         // 5-9   - Green
+			uint32_t b = (color >> 10) & 0x1F;        // 10-14 - Blue
+			
+			uint32_t R, G, B;
+			
+			if(correction == ColorCorrection::LCD) {
+				// Same mix as Gambatte, each channel bleeds into the others a bit, tops out at 248
+				R = (r * 13 + g * 2 + b) >> 1;
+				G = (g * 3 + b) << 1;
+				B = (r * 3 + g * 2 + b * 11) >> 1;
+			} else {
+				R = (r * 255) / 31;
+				G = (g * 255) / 31;
+				B = (b * 255) / 31;
+			}
+			
+			table[color] = (static_cast<uint32_t>(0xFF) << 24) | (R << 16) | (G << 8) | B;
 		}
-	}
+		
+		return table;
+	};
 	
-	pixels[(y * WIDTH) + x] = color;
-	/*uint32_t* pixels = static_cast<uint32_t*>(surface->pixels);
-	pixels[(y * surface->w) + x] = color;*/
+	// Only built the first time they're asked for
+	if(correction == ColorCorrection::LCD) {
+		static const std::vector<uint32_t> lcd = build(ColorCorrection::LCD);
+		return lcd.data();
+	}
 	
-	if (SDL_MUSTLOCK(surface)) {
-		SDL_UnlockSurface(surface);
+	static const std::vector<uint32_t> raw = build(ColorCorrection::Raw);
+	return raw.data();
+}
+
+void PPU::checkLYCInterrupt() {
+	if(lcdc.lycInc && lcdc.LY == lcdc.LYC) {
+		interrupt |= 0x02;
 	}
 }
 
@@ -742,8 +672,30 @@ void PPU::reset(const uint32_t& clock) {
 	//frames = 0;
 }
 
-SDL_Texture* PPU::createTexture(uint32_t width, uint32_t height) {
-	return SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888,
-											 SDL_TEXTUREACCESS_STREAMING,
-											 width, height);
+void PPU::serialize(Serializer& s) {
+	s(mode);
+	s(currentDot);
+	s(winLineCounter);
+	s(drawWindow);
+	s(interrupt);
+	
+	s(bgp);
+	s(obj0);
+	s(obj1);
+	s(BGPalette);
+	s(OBJ0Palette);
+	s(OBJ1Palette);
+	
+	s(CBGPalette);
+	s(bgIndex);
+	s(COBJPalette);
+	s(objIndex);
+	s(autoIncrementBG);
+	s(autoIncrementOBJ);
+	s(opri);
+	
+	if(s.isLoading())
+		setColorCorrection(colorCorrection);
+	
+	s(pixels);
 }
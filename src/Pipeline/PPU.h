@@ -2,8 +2,7 @@
 
 #include <cstdint>
 
-#include <SDL_render.h>
-#include <SDL_video.h>
+#include "Scanline.h"
 
 class VRAM;
 class OAM;
@@ -11,6 +10,8 @@ class OAM;
 class LCDC;
 
 class MMU;
+class Cartridge;
+class Serializer;
 
 class PPU {
 public:
@@ -21,53 +22,65 @@ public:
 		VRAMTransfer = 3
 	};
 
-	enum BGPriority {
-		None,
-		Priority,
-		Zero
+	// How CGB RGB555 colors end up on screen
+	enum class ColorCorrection {
+		// Each channel stretched from 5 to 8 bits
+		Raw,
+		
+		// Mixed and dimmed like the CGB's LCD, games were made to look right on it
+		LCD
 	};
 	
 public:
-	PPU(VRAM& vram, OAM& oam, LCDC& lcdc, MMU& mmu)
+	PPU(VRAM& vram, OAM& oam, LCDC& lcdc, MMU& mmu, const Cartridge& cartridge)
 		: vram(vram),
 		  oam(oam),
 		  lcdc(lcdc),
-		  mmu(mmu) {
-		
+		  mmu(mmu),
+		  cartridge(cartridge) {
+		setColorCorrection(ColorCorrection::Raw);
 	}
 	
 	void tick(int cycles);
 	void updateMode(PPUMode mode);
 	
+	/**
+	 * Dots until 'tick' would change the mode or LY,
+	 * UINT32_MAX while the LCD is off.
+	 */
+	uint32_t cyclesUntilEvent() const;
+	
 	void drawScanline();
-	void drawBackground();
+	
+	// False when neither the background nor the window is on
+	bool drawBackground();
 	void drawSprites();
 	
+	/**
+	 * Background/window pixels 'from' to 'to' on the current line into 'scanline',
+	 * a tile row at a time, ('u', 'v') is where 'from' is in the tile map.
+	 */
+	void drawTiles(uint32_t from, uint32_t to, uint16_t tilemapAddr, uint8_t u, uint8_t v);
+	
 	uint8_t fetch8(uint16_t address);
 	void write8(uint16_t address, uint8_t data);
 	
 	void checkLYCInterrupt();
 	
-	void createWindow();
-	
-	void updatePixel(uint32_t x, uint32_t y, uint32_t color);
-	void setPixel(uint32_t x, uint32_t y, uint32_t color);
 	void reset(const uint32_t& clock);
 	
-	// TODO; Remove
+	// Includes the screen, so a loaded state shows the right frame
+	void serialize(Serializer& s);
 	
-	uint32_t convertRGB555ToSDL(uint16_t color) {
-		uint8_t r = (color >> 0) & 0x1F;         // 0-4   - Red
-		uint8_t g = (color >> 5) & 0x1F;         // 5-9   - Green
-		uint8_t b = (color >> 10) & 0x1F;        // 10-14 - Blue
-		
-		r = (r * 255) / 31;
-		g = (g * 255) / 31;
-		b = (b * 255) / 31;
-		
-		// Return combined 32-bit color
-		return (static_cast<uint32_t>(0xFF) << 24) | (r << 16) | (g << 8) | b;
-	}
+	/**
+	 * Swaps the RGB555 -> ARGB8888 table and rebuilds the CGB colors,
+	 * takes effect from the next drawn line.
+	 */
+	void setColorCorrection(ColorCorrection correction);
+	ColorCorrection getColorCorrection() const { return colorCorrection; }
+	
+	// 32768 entries, indexed by the RGB555 value
+	static const uint32_t* colorTable(ColorCorrection correction);
 	
 	const uint32_t COLOR_WHITE = 0xFFFFFF;  // White
 	const uint32_t COLOR_LIGHT_GRAY = 0xAAAAAA;  // Light Gray
@@ -89,10 +102,12 @@ public:
 		}
 	}
 	
-	SDL_Texture* createTexture(uint32_t width, uint32_t height);
-
 public:
-	static PPUMode mode;
+	static constexpr uint32_t SCREEN_WIDTH  = 160;
+	static constexpr uint32_t SCREEN_HEIGHT = 144;
+	
+public:
+	PPUMode mode = HBlank;
 
 private:
 	//bool test = false;
@@ -101,7 +116,7 @@ private:
 	
 	bool drawWindow = false;
 	
-	BGPriority bgPriority[160] = { Zero };
+	Scanline scanline;
 	
 public:
 	uint8_t interrupt = 0;
@@ -116,23 +131,25 @@ public:
 private:
 	MMU& mmu;
 	
+	const Cartridge& cartridge;
+	
 public:
 	uint8_t bgp = 0;
 	uint8_t obj0 = 0;
 	uint8_t obj1 = 0;
 	
-	uint8_t BGPalette[4];
-	uint8_t OBJ0Palette[4];
-	uint8_t OBJ1Palette[4];
+	uint8_t BGPalette[4] = { 0 };
+	uint8_t OBJ0Palette[4] = { 0 };
+	uint8_t OBJ1Palette[4] = { 0 };
 	
 	// CGB
 	
 	// Background
-	uint8_t CBGPalette[64];
+	uint8_t CBGPalette[64] = { 0 };
 	uint8_t bgIndex = 0;
 	
 	// Sprite
-	uint8_t COBJPalette[64];
+	uint8_t COBJPalette[64] = { 0 };
 	uint8_t objIndex = 0;
 	
 	// BCPS/BGPI
@@ -146,14 +163,39 @@ public:
 	
 	bool opri = false;
 	
+private:
+	/**
+	 * The palettes above as ready to blit colors, the renderer only indexes these.
+	 * Rebuilt when a palette register is written, a state is loaded,
+	 * or the color correction changes. Not saved, they're derived.
+	 *
+	 * [BG, OBJ][palette][color], laid out like the indices in 'scanline'.
+	 * DMG only uses BG palette 0 and OBJ palettes 0-1 (OBP0/OBP1).
+	 */
+	uint32_t DMGColors[2][8][4] = { { { 0 } } };
+	uint32_t CGBColors[2][8][4] = { { { 0 } } };
+	
+	ColorCorrection colorCorrection = ColorCorrection::Raw;
+	const uint32_t* rgb555 = nullptr;
+	
+	void updateDMGColors();
+	
+	// 'index' is the byte that changed in CBGPalette/COBJPalette
+	void updateCGBColor(bool obj, uint8_t index);
+	
 public:
-	SDL_Window* window;
-	SDL_GLContext sdl_context;
-	SDL_Renderer* renderer;
-	SDL_Surface* surface;
+	/**
+	 * ARGB8888 framebuffer, the frontend,
+	 * is the one that uploads it to the screen.
+	 */
+	uint32_t pixels[SCREEN_WIDTH * SCREEN_HEIGHT] = { 0 };
 	
-	SDL_Texture* texture;
+	/**
+	 * Off for frames nobody is going to see (run-ahead),
+	 * only 'pixels' depends on the drawing.
+	 */
+	bool render = true;
 	
-	int pitch;
-	uint32_t* pixels;
+	// Off composes lines with the scalar code, for comparing against the SIMD one
+	bool simd = true;
 };
@@ -0,0 +1,73 @@
+#include "Scanline.h"
+
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SCANLINE_SSE2
+#endif
+
+void Scanline::compose(const uint32_t* colors, uint32_t* out, bool background) {
+#ifdef SCANLINE_SSE2
+	const __m128i zero = _mm_setzero_si128();
+	
+	// Without a background every pixel counts as BG color 0, and there's nothing to fall back to
+	const __m128i colorMask = background ? _mm_set1_epi8(0x03) : zero;
+	const __m128i bgMask = background ? _mm_set1_epi8(-1) : zero;
+	
+	for(uint32_t x = 0; x < WIDTH; x += 16) {
+		__m128i bgIndex = _mm_and_si128(_mm_load_si128(reinterpret_cast<const __m128i*>(bg + x)), bgMask);
+		__m128i over = _mm_and_si128(_mm_load_si128(reinterpret_cast<const __m128i*>(bgOver + x)), bgMask);
+		__m128i all = _mm_load_si128(reinterpret_cast<const __m128i*>(objAll + x));
+		__m128i front = _mm_load_si128(reinterpret_cast<const __m128i*>(objFront + x));
+		
+		// BG color 0 lets every sprite through, 1-3 only the ones in front
+		__m128i bgZero = _mm_cmpeq_epi8(_mm_and_si128(bgIndex, colorMask), zero);
+		__m128i obj = _mm_or_si128(_mm_and_si128(bgZero, all), _mm_andnot_si128(bgZero, front));
+		
+		obj = _mm_andnot_si128(over, obj);
+		
+		// No sprite left -> BG
+		__m128i none = _mm_cmpeq_epi8(obj, zero);
+		__m128i index = _mm_or_si128(_mm_and_si128(none, bgIndex), obj);
+		
+		_mm_store_si128(reinterpret_cast<__m128i*>(picked + x), index);
+	}
+	
+	// No gather in SSE2, the lookup is a plain loop
+	if(background) {
+		for(uint32_t x = 0; x < WIDTH; x++) {
+			out[x] = colors[picked[x]];
+		}
+	} else {
+		for(uint32_t x = 0; x < WIDTH; x++) {
+			out[x] = picked[x] ? colors[picked[x]] : out[x];
+		}
+	}
+#else
+	composeScalar(colors, out, background);
+#endif
+}
+
+void Scanline::composeScalar(const uint32_t* colors, uint32_t* out, bool background) const {
+	for(uint32_t x = 0; x < WIDTH; x++) {
+		uint8_t obj = 0;
+		
+		if(!background || (bg[x] & 0x03) == 0) {
+			obj = objAll[x];
+		} else if(!bgOver[x]) {
+			obj = objFront[x];
+		}
+		
+		if(obj != 0) {
+			out[x] = colors[obj];
+		} else if(background) {
+			out[x] = colors[bg[x]];
+		}
+	}
+}
+
+void Scanline::clearObjects() {
+	std::memset(objAll, 0, sizeof(objAll));
+	std::memset(objFront, 0, sizeof(objFront));
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+ * One line as the PPU draws it, before it becomes colors.
+ *
+ * The background/window and the sprites are drawn separately into these,
+ * as indices into a 64 color table (BG 0-31, OBJ 32-63, 'palette * 4 + color'),
+ * then 'compose' picks which one shows for every pixel and looks up the color.
+ *
+ * Sprites are kept twice so the BG priority doesn't need to be checked per sprite:
+ * 'objAll' has every sprite, 'objFront' only the ones without the "behind BG" flag.
+ * Whichever shows depends only on the BG pixel under it,
+ *
+ * BG color 0        -> objAll
+ * BG color 1-3      -> objFront
+ * CGB priority tile -> no sprites
+ */
+
+class Scanline {
+public:
+	static constexpr uint32_t WIDTH = 160;
+	
+	/**
+	 * 'colors' - 64 colors, see above
+	 * 'background' - Off when no BG/window was drawn, only sprites are written then
+	 *
+	 * SSE2 when the compiler has it, 16 pixels at a time.
+	 */
+	void compose(const uint32_t* colors, uint32_t* out, bool background);
+	
+	// Same result one pixel at a time, to check 'compose' against
+	void composeScalar(const uint32_t* colors, uint32_t* out, bool background) const;
+	
+	// Before drawing sprites
+	void clearObjects();
+
+public:
+	// BG/window color
+	alignas(16) uint8_t bg[WIDTH] = { 0 };
+	
+	// 0xFF where a CGB tile with the priority bit has a color other than 0
+	alignas(16) uint8_t bgOver[WIDTH] = { 0 };
+	
+	// OBJ color, 0 when there's no sprite
+	alignas(16) uint8_t objAll[WIDTH] = { 0 };
+	alignas(16) uint8_t objFront[WIDTH] = { 0 };
+
+private:
+	// 'compose' puts the picked indices here before looking them up
+	alignas(16) uint8_t picked[WIDTH] = { 0 };
+};
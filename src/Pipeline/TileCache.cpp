@@ -0,0 +1,30 @@
+#include "TileCache.h"
+
+void TileCache::invalidateAll() {
+	for(auto& bank : stale) {
+		for(bool& tile : bank) {
+			tile = true;
+		}
+	}
+}
+
+void TileCache::decode(uint8_t bank, uint16_t tile) {
+	// https://gbdev.io/pandocs/Tile_Data.html
+	const uint8_t* data = vram + bank * 0x2000 + tile * 16;
+	
+	for(uint8_t y = 0; y < 8; y++) {
+		uint8_t b0 = data[y * 2];
+		uint8_t b1 = data[y * 2 + 1];
+		
+		// Bit 7 is the leftmost pixel
+		for(uint8_t x = 0; x < 8; x++) {
+			uint8_t bit = 7 - x;
+			uint8_t pixel = static_cast<uint8_t>(((b0 >> bit) & 1) | (((b1 >> bit) & 1) << 1));
+			
+			rows[bank][tile][0][y][x] = pixel;
+			rows[bank][tile][1][y][7 - x] = pixel;
+		}
+	}
+	
+	stale[bank][tile] = false;
+}
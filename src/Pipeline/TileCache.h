@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+ * Tiles decoded into 2-bit color indices, one byte per pixel.
+ *
+ * Each tile is stored as is and mirrored on X, so a renderer
+ * gets a whole row of 8 pixels, left to right, from one lookup.
+ * Y flipping is just picking the other row.
+ *
+ * Both VRAM banks, 384 tiles each (0x8000-0x97FF).
+ * VRAM marks a tile stale when one of its bytes changes,
+ * it's decoded again the next time it's used.
+ */
+
+class TileCache {
+public:
+	static constexpr uint16_t TILES = 384;
+	
+	explicit TileCache(const uint8_t* vram) : vram(vram) {
+		invalidateAll();
+	}
+	
+	/**
+	 * 8 color indices (0-3), left to right.
+	 * 'tile' is 0-383, as if 0x8000 addressing was used.
+	 */
+	const uint8_t* row(uint8_t bank, uint16_t tile, uint8_t y, bool flipX) {
+		if(stale[bank][tile])
+			decode(bank, tile);
+		
+		return rows[bank][tile][flipX][y];
+	}
+	
+	// 'address' is the offset in VRAM, bank 1 starts at 0x2000
+	void invalidate(uint16_t address) {
+		if((address & 0x1FFF) < TILES * 16)
+			stale[address >> 13][(address & 0x1FFF) >> 4] = true;
+	}
+	
+	void invalidateAll();
+
+private:
+	void decode(uint8_t bank, uint16_t tile);
+
+private:
+	const uint8_t* vram;
+	
+	// [bank][tile][flipped on X][y][x]
+	uint8_t rows[2][TILES][2][8][8] = {};
+	bool stale[2][TILES] = {};
+};
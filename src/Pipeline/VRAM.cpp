@@ -6,6 +6,7 @@
 
 #include "../Memory/Cartridge.h"
 #include "../Utility/Bitwise.h"
+#include "../Utility/Serializer.h"
 
 uint8_t VRAM::fetch8(uint16_t address) {
     if(address == 0xFF4F) {
@@ -15,7 +16,7 @@ uint8_t VRAM::fetch8(uint16_t address) {
          * Reading from this register will return the number of the currently loaded VRAM bank in bit 0,
          * and all other bits will be set to 1.
          */
-        if(Cartridge::mode != Color) return 0xFF;
+        if(cartridge.mode != Color) return 0xFF;
         
         return 0b11111110 | vramBank;
     }
@@ -32,7 +33,7 @@ uint8_t VRAM::fetch8(uint16_t address) {
 void VRAM::write8(uint16_t address, uint8_t data) {
     if(address == 0xFF4F) {
         // https://gbdev.io/pandocs/CGB_Registers.html#ff4f--vbk-cgb-mode-only-vram-bank
-        if(Cartridge::mode != Color) return;
+        if(cartridge.mode != Color) return;
         
         vramBank = check_bit(data, 0);
         
@@ -45,5 +46,16 @@ void VRAM::write8(uint16_t address, uint8_t data) {
     
     uint16_t addr = (vramBank * 0x2000) + (address & 0x1FFF);
     
-    RAM[addr] = data;
-}
\ No newline at end of file
+    if(RAM[addr] != data) {
+        RAM[addr] = data;
+        tiles.invalidate(addr);
+    }
+}
+
+void VRAM::serialize(Serializer& s) {
+	s(vramBank);
+	s.bytes(RAM, 0x2000 * 2);
+	
+	if(s.isLoading())
+		tiles.invalidateAll();
+}
@@ -2,20 +2,29 @@
 
 #include <cstdint>
 
+#include "TileCache.h"
+
 /*
  * VRAM can be locked
  */
 
 class LCDC;
+class Cartridge;
+class Serializer;
 struct TileData;
 
 class VRAM {
 public:
-	VRAM(LCDC& lcdc) : lcdc(lcdc) {}
+	VRAM(LCDC& lcdc, const Cartridge& cartridge) : lcdc(lcdc), cartridge(cartridge) {}
 	
     uint8_t fetch8(uint16_t address);
     void write8(uint16_t address, uint8_t data);
 	
+	uint8_t getBank() const { return vramBank; }
+	
+	// Only the 2 banks that are actually used
+	void serialize(Serializer& s);
+	
 private:
 	/**
 	 * 0 = Bank 0
@@ -25,6 +34,14 @@ private:
 	
 	LCDC& lcdc;
 	
+	const Cartridge& cartridge;
+	
 public:
     uint8_t RAM[0x4000 * 4] = { 0 };
+	
+	/**
+	 * Kept in sync by 'write8', anything that writes
+	 * to 'RAM' directly has to invalidate it.
+	 */
+	TileCache tiles { RAM };
 };
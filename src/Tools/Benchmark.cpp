@@ -0,0 +1,559 @@
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Core/GameBoy.h"
+#include "Core/VecEnv.h"
+
+/**
+ * Microbenchmarks for the hot paths of each component,
+ * every one of them runs on its own, outside of 'GameBoy::step'.
+ *
+ * Each benchmark is run with more and more iterations,
+ * until it takes at least '--min-time' seconds (0.25 by default).
+ *
+ * Usage: gb_bench [--filter text] [--min-time seconds] [--json file]
+ * '--json -' writes the JSON to stdout instead of the table.
+ */
+
+// Keeps the compiler from throwing away results
+static volatile uint64_t sink = 0;
+
+/**
+ * Sets everything up and returns what gets timed,
+ * which runs 'iterations' times and returns how many operations it did.
+ */
+using Run = std::function<uint64_t(uint64_t iterations)>;
+
+struct Benchmark {
+	const char* name;
+	
+	// What an operation is, for the report
+	const char* unit;
+	
+	std::function<Run()> setup;
+};
+
+struct Result {
+	std::string name;
+	std::string unit;
+	
+	uint64_t iterations = 0;
+	uint64_t operations = 0;
+	double seconds = 0;
+};
+
+/**
+ * Minimal cartridge, 'code' is placed at 0x150,
+ * which is where the header jumps to.
+ */
+static std::vector<uint8_t> makeRom(uint8_t type, uint8_t romSize, uint8_t ramSize, bool color,
+									const std::vector<uint8_t>& code = {}) {
+	std::vector<uint8_t> rom(static_cast<size_t>(0x8000) << romSize, 0);
+	
+	// NOP; JP 0x150
+	rom[0x100] = 0x00;
+	rom[0x101] = 0xC3;
+	rom[0x102] = 0x50;
+	rom[0x103] = 0x01;
+	
+	rom[0x143] = color ? 0xC0 : 0x00;
+	rom[0x147] = type;
+	rom[0x148] = romSize;
+	rom[0x149] = ramSize;
+	
+	// Every bank starts with its own number, so banked reads differ
+	for(size_t bank = 1; bank < rom.size() / 0x4000; bank++) {
+		for(size_t i = 0; i < 0x4000; i++) {
+			rom[bank * 0x4000 + i] = static_cast<uint8_t>(bank + i);
+		}
+	}
+	
+	std::memcpy(rom.data() + 0x150, code.data(), code.size());
+	
+	return rom;
+}
+
+static std::shared_ptr<GameBoy> makeGameBoy(const std::vector<uint8_t>& rom) {
+	// No boot ROM, starts at 0x100
+	return std::make_shared<GameBoy>(rom, std::vector<uint8_t>());
+}
+
+/**
+ * Opcodes that only touch registers, WRAM (through HL),
+ * or the stack; nothing that jumps, halts or writes to IO.
+ */
+static std::vector<uint8_t> instructionMix(const char* kind) {
+	std::vector<uint8_t> opcodes;
+	
+	if(std::strcmp(kind, "alu") == 0) {
+		// ADD/ADC/SUB/SBC/AND/XOR/OR/CP r, INC/DEC r
+		for(uint8_t op = 0x80; op < 0xC0; op++) {
+			opcodes.push_back(op);
+		}
+		
+		for(uint8_t r = 0; r < 8; r++) {
+			opcodes.push_back(static_cast<uint8_t>(0x04 | r << 3));
+			opcodes.push_back(static_cast<uint8_t>(0x05 | r << 3));
+		}
+	} else if(std::strcmp(kind, "load") == 0) {
+		// LD r, r' (no HALT)
+		for(uint16_t op = 0x40; op < 0x80; op++) {
+			if(op != 0x76)
+				opcodes.push_back(static_cast<uint8_t>(op));
+		}
+		
+		// LD r, u8
+		for(uint8_t r = 0; r < 8; r++) {
+			opcodes.push_back(static_cast<uint8_t>(0x06 | r << 3));
+		}
+	} else if(std::strcmp(kind, "cb") == 0) {
+		// Every CB opcode
+		for(uint16_t i = 0; i < 0x100; i++) {
+			opcodes.push_back(0xCB);
+		}
+	} else if(std::strcmp(kind, "stack") == 0) {
+		// PUSH/POP pairs, so SP stays put
+		for(uint8_t p = 0; p < 4; p++) {
+			opcodes.push_back(static_cast<uint8_t>(0xC5 | p << 4));
+			opcodes.push_back(static_cast<uint8_t>(0xC1 | p << 4));
+		}
+		
+		// LD (HL+), A / LD A, (HL-)
+		opcodes.push_back(0x22);
+		opcodes.push_back(0x3A);
+	}
+	
+	return opcodes;
+}
+
+static Run cpuMix(const char* kind) {
+	auto gb = makeGameBoy(makeRom(0x00, 0, 0, false));
+	auto opcodes = instructionMix(kind);
+	
+	return [gb, opcodes](uint64_t iterations) {
+		CPU& cpu = gb->cpu;
+		uint64_t cycles = 0;
+		
+		for(uint64_t i = 0; i < iterations; i++) {
+			// Keep memory accesses in WRAM
+			cpu.HL = 0xC100;
+			cpu.SP = 0xDFF0;
+			
+			for(size_t j = 0; j < opcodes.size(); j++) {
+				cpu.operands[0] = static_cast<uint8_t>(j);
+				cycles += cpu.decodeInstruction(opcodes[j]);
+			}
+		}
+		
+		sink = sink + cycles;
+		
+		return iterations * opcodes.size();
+	};
+}
+
+/**
+ * Whole fetch/decode/execute through 'CPU::cycle',
+ * an ALU/load loop running from ROM.
+ */
+static Run cpuCycle(bool decodeCache) {
+	std::vector<uint8_t> code;
+	
+	for(uint8_t op = 0x80; op < 0xC0; op++) {
+		if((op & 7) != 6) code.push_back(op);
+	}
+	
+	for(uint8_t op = 0x40; op < 0x80; op++) {
+		if((op & 7) != 6 && (op & 0xF8) != 0x70) code.push_back(op);
+	}
+	
+	// JP 0x150
+	code.push_back(0xC3);
+	code.push_back(0x50);
+	code.push_back(0x01);
+	
+	auto gb = makeGameBoy(makeRom(0x00, 0, 0, false, code));
+	gb->cpu.useDecodeCache = decodeCache;
+	gb->interruptHandler.IME = false;
+	
+	return [gb](uint64_t iterations) {
+		uint64_t cycles = 0;
+		
+		for(uint64_t i = 0; i < iterations; i++) {
+			cycles += gb->cpu.cycle();
+		}
+		
+		sink = sink + cycles;
+		
+		return iterations;
+	};
+}
+
+/**
+ * 256 reads or writes starting at 'address', wrapping around at 'mask',
+ * the cartridge has RAM and it's enabled.
+ */
+static Run mmuAccess(uint16_t address, bool write, uint8_t mask = 0xFF) {
+	auto gb = makeGameBoy(makeRom(0x1B, 5, 3, true));
+	gb->mmu.write8(0x0000, 0x0A);
+	
+	return [gb, address, write, mask](uint64_t iterations) {
+		MMU& mmu = gb->mmu;
+		uint64_t sum = 0;
+		
+		for(uint64_t i = 0; i < iterations; i++) {
+			for(uint16_t j = 0; j < 0x100; j++) {
+				const uint16_t at = static_cast<uint16_t>(address + (j & mask));
+				
+				if(write) {
+					mmu.write8(at, static_cast<uint8_t>(i + j));
+				} else {
+					sum += mmu.fetch8(at);
+				}
+			}
+		}
+		
+		sink = sink + sum;
+		
+		return iterations * 0x100;
+	};
+}
+
+/**
+ * Switches the ROM bank, then reads 256 bytes out of it.
+ */
+static Run mbcBankedRead(uint8_t type) {
+	auto gb = makeGameBoy(makeRom(type, 5, 3, false));
+	
+	return [gb](uint64_t iterations) {
+		MMU& mmu = gb->mmu;
+		uint64_t sum = 0;
+		
+		for(uint64_t i = 0; i < iterations; i++) {
+			mmu.write8(0x2000, static_cast<uint8_t>(1 + (i & 0x1F)));
+			
+			for(uint16_t j = 0; j < 0x100; j++) {
+				sum += mmu.fetch8(static_cast<uint16_t>(0x4000 + ((i << 8) & 0x3F00) + j));
+			}
+		}
+		
+		sink = sink + sum;
+		
+		return iterations * 0x100;
+	};
+}
+
+/**
+ * Background + window + 10 sprites on every line.
+ * 'simd' off composes the lines with the scalar fallback.
+ */
+static Run ppuScanline(bool color, bool simd = true) {
+	auto gb = makeGameBoy(makeRom(0x00, 0, 0, color));
+	MMU& mmu = gb->mmu;
+	PPU& ppu = gb->ppu;
+	
+	ppu.simd = simd;
+	
+	// LCD off so VRAM/OAM are always accessible
+	mmu.write8(0xFF40, 0x00);
+	
+	for(uint16_t i = 0; i < 0x2000; i++) {
+		mmu.write8(static_cast<uint16_t>(0x8000 + i), static_cast<uint8_t>(i * 7));
+	}
+	
+	if(color) {
+		// Attributes in bank 1, and some palettes
+		mmu.write8(0xFF4F, 1);
+		
+		for(uint16_t i = 0x1800; i < 0x2000; i++) {
+			mmu.write8(static_cast<uint16_t>(0x8000 + i), static_cast<uint8_t>(i & 0x2F));
+		}
+		
+		mmu.write8(0xFF4F, 0);
+		
+		mmu.write8(0xFF68, 0x80);
+		mmu.write8(0xFF6A, 0x80);
+		
+		for(uint8_t i = 0; i < 64; i++) {
+			mmu.write8(0xFF69, static_cast<uint8_t>(i * 37));
+			mmu.write8(0xFF6B, static_cast<uint8_t>(i * 53));
+		}
+	}
+	
+	mmu.write8(0xFF47, 0xE4);
+	mmu.write8(0xFF48, 0xD2);
+	mmu.write8(0xFF49, 0x1B);
+	
+	// 10 sprites on lines 40-47
+	for(uint8_t i = 0; i < 40; i++) {
+		uint16_t sprite = static_cast<uint16_t>(0xFE00 + i * 4);
+		
+		mmu.write8(sprite + 0, i < 10 ? 40 + 16 : 0);
+		mmu.write8(sprite + 1, static_cast<uint8_t>(8 + i * 14));
+		mmu.write8(sprite + 2, i);
+		mmu.write8(sprite + 3, static_cast<uint8_t>((i & 3) << 5 | (i & 1) << 4 | (i & 7)));
+	}
+	
+	// Window halfway across, from line 0
+	mmu.write8(0xFF4A, 0);
+	mmu.write8(0xFF4B, 87);
+	
+	// LCD, window (9C00), BG/window data at 8000, sprites, BG
+	mmu.write8(0xFF40, 0xF3);
+	
+	gb->lcdc.LY = 0;
+	ppu.updateMode(PPU::VRAMTransfer);
+	
+	return [gb](uint64_t iterations) {
+		PPU& ppu = gb->ppu;
+		
+		for(uint64_t i = 0; i < iterations; i++) {
+			gb->lcdc.LY = static_cast<uint8_t>(40 + (i & 7));
+			ppu.drawScanline();
+		}
+		
+		sink = sink + ppu.pixels[40 * PPU::SCREEN_WIDTH + 80];
+		
+		return iterations;
+	};
+}
+
+/**
+ * All 4 channels playing, 1024 stereo samples at a time.
+ */
+static Run apuSamples() {
+	auto gb = makeGameBoy(makeRom(0x00, 0, 0, false));
+	MMU& mmu = gb->mmu;
+	
+	gb->apu.enableAudio = true;
+	
+	const uint8_t writes[][2] = {
+		{ 0x26, 0x80 }, { 0x24, 0x77 }, { 0x25, 0xFF },
+		
+		{ 0x11, 0x80 }, { 0x12, 0xF0 }, { 0x13, 0x00 }, { 0x14, 0x87 },
+		{ 0x16, 0x40 }, { 0x17, 0xF0 }, { 0x18, 0x80 }, { 0x19, 0x86 },
+		{ 0x1A, 0x80 }, { 0x1C, 0x20 }, { 0x1D, 0x00 }, { 0x1E, 0x86 },
+		{ 0x21, 0xF0 }, { 0x22, 0x55 }, { 0x23, 0x80 },
+	};
+	
+	for(const auto& write : writes) {
+		mmu.write8(static_cast<uint16_t>(0xFF00 | write[0]), write[1]);
+	}
+	
+	for(uint8_t i = 0; i < 16; i++) {
+		mmu.write8(static_cast<uint16_t>(0xFF30 + i), static_cast<uint8_t>(i * 0x11));
+	}
+	
+	auto buffer = std::make_shared<std::vector<uint8_t>>(2048);
+	
+	return [gb, buffer](uint64_t iterations) {
+		for(uint64_t i = 0; i < iterations; i++) {
+			gb->apu.generateSamples(buffer->data(), static_cast<int>(buffer->size()));
+		}
+		
+		sink = sink + (*buffer)[100];
+		
+		return iterations * (buffer->size() / 2);
+	};
+}
+
+/**
+ * Whole machine save state (CGB, MBC5 with 32KB of RAM),
+ * loading always goes back to the same one.
+ */
+static Run stateSaveLoad(bool load) {
+	auto gb = makeGameBoy(makeRom(0x1B, 2, 3, true));
+	auto state = std::make_shared<std::vector<uint8_t>>();
+	
+	gb->runFrame();
+	gb->saveState(*state);
+	
+	return [gb, state, load](uint64_t iterations) {
+		for(uint64_t i = 0; i < iterations; i++) {
+			if(load) gb->loadState(*state);
+			else gb->saveState(*state);
+		}
+		
+		sink = sink + gb->cpu.PC;
+		
+		return iterations;
+	};
+}
+
+/**
+ * Whole frames over 16 instances on the thread pool,
+ * each one spinning on 'INC A; JR -3', so there's nothing to skip.
+ */
+static Run vecEnvStep() {
+	const size_t count = 16;
+	
+	auto env = std::make_shared<VecEnv>(RomImage::fromBytes(makeRom(0x00, 0, 0, false, { 0x3C, 0x18, 0xFD })), count);
+	auto inputs = std::make_shared<std::vector<uint8_t>>(count, 0);
+	
+	return [env, inputs, count](uint64_t iterations) {
+		for(uint64_t i = 0; i < iterations; i++) {
+			env->step(inputs->data());
+		}
+		
+		sink = sink + env->screens()[0];
+		
+		return iterations * count;
+	};
+}
+
+static std::vector<Benchmark> benchmarks() {
+	return {
+		{ "cpu/decode/alu",         "instruction", [] { return cpuMix("alu"); } },
+		{ "cpu/decode/load",        "instruction", [] { return cpuMix("load"); } },
+		{ "cpu/decode/cb",          "instruction", [] { return cpuMix("cb"); } },
+		{ "cpu/decode/stack",       "instruction", [] { return cpuMix("stack"); } },
+		{ "cpu/cycle/decode_cache", "instruction", [] { return cpuCycle(true); } },
+		{ "cpu/cycle/fetch",        "instruction", [] { return cpuCycle(false); } },
+		
+		{ "mmu/read/rom0",  "access", [] { return mmuAccess(0x0100, false); } },
+		{ "mmu/read/romx",  "access", [] { return mmuAccess(0x4100, false); } },
+		{ "mmu/read/vram",  "access", [] { return mmuAccess(0x8100, false); } },
+		{ "mmu/read/sram",  "access", [] { return mmuAccess(0xA100, false); } },
+		{ "mmu/read/wram",  "access", [] { return mmuAccess(0xC100, false); } },
+		{ "mmu/read/echo",  "access", [] { return mmuAccess(0xE100, false); } },
+		{ "mmu/read/oam",   "access", [] { return mmuAccess(0xFE00, false); } },
+		{ "mmu/read/hram",  "access", [] { return mmuAccess(0xFF80, false, 0x7F); } },
+		{ "mmu/read/io",    "access", [] { return mmuAccess(0xFF40, false, 0x07); } },
+		{ "mmu/write/vram", "access", [] { return mmuAccess(0x8100, true); } },
+		{ "mmu/write/sram", "access", [] { return mmuAccess(0xA100, true); } },
+		{ "mmu/write/wram", "access", [] { return mmuAccess(0xC100, true); } },
+		{ "mmu/write/oam",  "access", [] { return mmuAccess(0xFE00, true); } },
+		
+		{ "ppu/scanline/dmg", "line", [] { return ppuScanline(false); } },
+		{ "ppu/scanline/cgb", "line", [] { return ppuScanline(true); } },
+		{ "ppu/scanline/dmg/scalar", "line", [] { return ppuScanline(false, false); } },
+		{ "ppu/scanline/cgb/scalar", "line", [] { return ppuScanline(true, false); } },
+		
+		{ "apu/samples", "sample", [] { return apuSamples(); } },
+		
+		{ "state/save", "state", [] { return stateSaveLoad(false); } },
+		{ "state/load", "state", [] { return stateSaveLoad(true); } },
+		
+		{ "vecenv/step", "frame", [] { return vecEnvStep(); } },
+		
+		{ "mbc/mbc1/banked_read", "access", [] { return mbcBankedRead(0x03); } },
+		{ "mbc/mbc3/banked_read", "access", [] { return mbcBankedRead(0x13); } },
+		{ "mbc/mbc5/banked_read", "access", [] { return mbcBankedRead(0x1B); } },
+	};
+}
+
+static Result measure(const Benchmark& benchmark, double minTime) {
+	Run run = benchmark.setup();
+	
+	Result result;
+	result.name = benchmark.name;
+	result.unit = benchmark.unit;
+	
+	// Warm up
+	run(1);
+	
+	uint64_t iterations = 1;
+	
+	while(true) {
+		auto start = std::chrono::steady_clock::now();
+		uint64_t operations = run(iterations);
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		
+		result.iterations = iterations;
+		result.operations = operations;
+		result.seconds = elapsed.count();
+		
+		if(result.seconds >= minTime || iterations >= (1ull << 40))
+			break;
+		
+		// Aim a bit past 'minTime', but never more than 10x at once
+		double scale = result.seconds > 0 ? minTime * 1.2 / result.seconds : 10.0;
+		
+		if(scale > 10.0) scale = 10.0;
+		if(scale < 2.0) scale = 2.0;
+		
+		iterations = static_cast<uint64_t>(static_cast<double>(iterations) * scale);
+	}
+	
+	return result;
+}
+
+static void writeJson(FILE* file, const std::vector<Result>& results) {
+	fprintf(file, "{\n  \"benchmarks\": [\n");
+	
+	for(size_t i = 0; i < results.size(); i++) {
+		const Result& result = results[i];
+		
+		fprintf(file, "    { \"name\": \"%s\", \"unit\": \"%s\", \"iterations\": %llu, \"operations\": %llu, "
+					  "\"seconds\": %.6f, \"ns_per_op\": %.4f, \"ops_per_second\": %.1f }%s\n",
+				result.name.c_str(), result.unit.c_str(),
+				static_cast<unsigned long long>(result.iterations),
+				static_cast<unsigned long long>(result.operations),
+				result.seconds, result.seconds * 1e9 / result.operations,
+				result.operations / result.seconds,
+				i + 1 < results.size() ? "," : "");
+	}
+	
+	fprintf(file, "  ]\n}\n");
+}
+
+int main(int argc, char* argv[]) {
+	std::string filter;
+	std::string jsonPath;
+	double minTime = 0.25;
+	
+	for(int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		
+		if(arg == "--filter" && i + 1 < argc) {
+			filter = argv[++i];
+		} else if(arg == "--min-time" && i + 1 < argc) {
+			minTime = std::stod(argv[++i]);
+		} else if(arg == "--json" && i + 1 < argc) {
+			jsonPath = argv[++i];
+		} else {
+			printf("Usage: gb_bench [--filter text] [--min-time seconds] [--json file]\n");
+			
+			return 1;
+		}
+	}
+	
+	const bool table = jsonPath != "-";
+	std::vector<Result> results;
+	
+	for(const Benchmark& benchmark : benchmarks()) {
+		if(!filter.empty() && std::string(benchmark.name).find(filter) == std::string::npos)
+			continue;
+		
+		Result result = measure(benchmark, minTime);
+		results.push_back(result);
+		
+		if(table) {
+			printf("%-24s %10.2f ns/%-12s %14.0f/s\n", result.name.c_str(),
+				   result.seconds * 1e9 / result.operations, result.unit.c_str(),
+				   result.operations / result.seconds);
+			fflush(stdout);
+		}
+	}
+	
+	if(jsonPath == "-") {
+		writeJson(stdout, results);
+	} else if(!jsonPath.empty()) {
+		FILE* file = fopen(jsonPath.c_str(), "w");
+		
+		if(!file) {
+			fprintf(stderr, "Can't write to %s\n", jsonPath.c_str());
+			
+			return 1;
+		}
+		
+		writeJson(file, results);
+		fclose(file);
+	}
+	
+	return 0;
+}
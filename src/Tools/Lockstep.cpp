@@ -0,0 +1,467 @@
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Core/GameBoy.h"
+#include "Core/Movie.h"
+
+/**
+ * Runs every ROM on two differently configured cores in lockstep,
+ * and stops at the first point where they don't agree.
+ *
+ * Whichever is behind runs, so they meet on every cycle both
+ * land on at an instruction boundary (or block, with the recompiler).
+ * There the registers are compared. The whole state (save states, so memory
+ * and everything else, IO, PPU, APU, timers..) is compared every instruction,
+ * scanline or frame, those flush both first so it's a lot slower per check.
+ *
+ * With --writes every byte the CPU wrote since the last meeting is compared too,
+ * that points right at the write that went wrong, but it needs a write hook,
+ * which takes every write off the fast paths (the write pages, the recompiler's
+ * inline stores), so those aren't what's being compared anymore.
+ *
+ * New implementations (another interpreter, PPU..) go in 'CORES',
+ * so they can be run against the reference.
+ *
+ * Usage: gb_lockstep [options] [rom/directory...]
+ *   --a core, --b core       - What to compare, cores joined with '+'
+ *                              (default interpreter vs reference)
+ *   --every instruction|scanline|frame
+ *                            - How often the whole state is compared (frame)
+ *   --frames n               - How long to run each ROM (600)
+ *   --writes                 - Compares every write, on the slow paths
+ *   --list                   - Every core there is
+ * Defaults to everything in Roms/tests.
+ */
+
+struct Core {
+	const char* name;
+	const char* description;
+	
+	// False if it isn't available here
+	std::function<bool(GameBoy&)> apply;
+};
+
+static const Core CORES[] = {
+	{ "interpreter", "the interpreter, as it normally runs", [](GameBoy& gb) {
+		return gb.setBackend(Backend::Interpreter);
+	} },
+	{ "recompiler", "the x86-64 recompiler", [](GameBoy& gb) {
+		return gb.setBackend(Backend::Recompiler);
+	} },
+	{ "cache", "uses the decode cache, instead of decoding every instruction", [](GameBoy& gb) {
+		gb.cpu.useDecodeCache = true;
+		return true;
+	} },
+	{ "noidle", "runs polling loops, instead of skipping them", [](GameBoy& gb) {
+		gb.skipIdleLoops = false;
+		return true;
+	} },
+	{ "reference", "the interpreter with every shortcut off (no cache, noidle)", [](GameBoy& gb) {
+		gb.cpu.useDecodeCache = false;
+		gb.skipIdleLoops = false;
+		return gb.setBackend(Backend::Interpreter);
+	} },
+};
+
+static const Core* findCore(const std::string& name) {
+	for(const Core& core : CORES) {
+		if(name == core.name)
+			return &core;
+	}
+	
+	return nullptr;
+}
+
+// "recompiler+noidle" -> both, in that order
+static bool parseCores(const std::string& spec, std::vector<const Core*>& cores) {
+	size_t start = 0;
+	
+	while(start <= spec.size()) {
+		size_t end = spec.find('+', start);
+		
+		if(end == std::string::npos)
+			end = spec.size();
+		
+		const Core* core = findCore(spec.substr(start, end - start));
+		
+		if(!core) {
+			printf("Unknown core '%s', see --list\n", spec.substr(start, end - start).c_str());
+			return false;
+		}
+		
+		cores.push_back(core);
+		start = end + 1;
+	}
+	
+	return true;
+}
+
+struct Side {
+	std::string name;
+	std::unique_ptr<GameBoy> gb;
+	
+	// CPU writes since the two last met, address << 8 | value
+	std::vector<uint32_t> writes;
+	
+	std::vector<uint8_t> state;
+};
+
+struct Options {
+	std::string a = "interpreter";
+	std::string b = "reference";
+	
+	// How often the whole state is compared
+	enum class Every { Instruction, Scanline, Frame } every = Every::Frame;
+	
+	uint32_t frames = 600;
+	
+	// Hook and compare every write, see above
+	bool writes = false;
+};
+
+static bool setup(Side& side, const std::string& spec, const std::filesystem::path& path, RomHandle rom, bool writes) {
+	std::vector<const Core*> cores;
+	
+	if(!parseCores(spec, cores))
+		return false;
+	
+	side.name = spec;
+	side.gb = std::make_unique<GameBoy>(rom, std::vector<uint8_t>(256, 0));
+	
+	for(const Core* core : cores) {
+		if(!core->apply(*side.gb)) {
+			printf("SKIP  %s (%s isn't available here)\n", path.string().c_str(), core->name);
+			return false;
+		}
+	}
+	
+	if(!writes)
+		return true;
+	
+	Side* self = &side;
+	side.gb->mmu.writeHook = [self](uint16_t address, uint8_t value) {
+		self->writes.push_back(static_cast<uint32_t>(address) << 8 | value);
+	};
+	side.gb->mmu.updatePages();
+	
+	return true;
+}
+
+static void dumpRegisters(Side& side, std::string& out) {
+	CPU& cpu = side.gb->cpu;
+	char buffer[256];
+	
+	snprintf(buffer, sizeof(buffer), "  %-12s PC=%04X SP=%04X AF=%04X BC=%04X DE=%04X HL=%04X IME=%d halted=%d\n",
+			 side.name.c_str(), cpu.PC, cpu.SP, cpu.AF.get(), cpu.BC.get(), cpu.DE.get(), cpu.HL.get(),
+			 side.gb->interruptHandler.IME, cpu.halted);
+	out += buffer;
+}
+
+// First register that differs, if any
+static bool sameRegisters(Side& a, Side& b, std::string& error) {
+	CPU& x = a.gb->cpu;
+	CPU& y = b.gb->cpu;
+	
+	const struct {
+		const char* name;
+		uint32_t x, y;
+	} registers[] = {
+		{ "PC", x.PC, y.PC },
+		{ "SP", x.SP, y.SP },
+		{ "A", x.AF.A, y.AF.A },
+		{ "F", x.AF.F, y.AF.F },
+		{ "B", x.BC.B, y.BC.B },
+		{ "C", x.BC.C, y.BC.C },
+		{ "D", x.DE.D, y.DE.D },
+		{ "E", x.DE.E, y.DE.E },
+		{ "H", x.HL.H, y.HL.H },
+		{ "L", x.HL.L, y.HL.L },
+		{ "IME", a.gb->interruptHandler.IME, b.gb->interruptHandler.IME },
+		{ "halted", x.halted, y.halted },
+	};
+	
+	for(const auto& reg : registers) {
+		if(reg.x == reg.y)
+			continue;
+		
+		char buffer[128];
+		snprintf(buffer, sizeof(buffer), "register %s; %s %X, %s %X\n", reg.name,
+				 a.name.c_str(), reg.x, b.name.c_str(), reg.y);
+		error = buffer;
+		
+		return false;
+	}
+	
+	return true;
+}
+
+static bool sameWrites(Side& a, Side& b, std::string& error) {
+	const size_t count = std::min(a.writes.size(), b.writes.size());
+	char buffer[128];
+	
+	for(size_t i = 0; i < count; i++) {
+		if(a.writes[i] == b.writes[i])
+			continue;
+		
+		snprintf(buffer, sizeof(buffer), "write %zu; %s [%04X] = %02X, %s [%04X] = %02X\n", i,
+				 a.name.c_str(), a.writes[i] >> 8, a.writes[i] & 0xFF,
+				 b.name.c_str(), b.writes[i] >> 8, b.writes[i] & 0xFF);
+		error = buffer;
+		
+		return false;
+	}
+	
+	if(a.writes.size() != b.writes.size()) {
+		const Side& more = a.writes.size() > b.writes.size() ? a : b;
+		
+		snprintf(buffer, sizeof(buffer), "only %s wrote [%04X] = %02X\n", more.name.c_str(),
+				 more.writes[count] >> 8, more.writes[count] & 0xFF);
+		error = buffer;
+		
+		return false;
+	}
+	
+	return true;
+}
+
+/**
+ * Compares save states, if they differ the first memory byte
+ * that does is reported, or where in the state they split.
+ */
+static bool sameState(Side& a, Side& b, std::string& error) {
+	// Not 'saveState', settling would keep the idle loop skipping from ever kicking in
+	a.gb->snapshot(a.state);
+	b.gb->snapshot(b.state);
+	
+	if(a.state == b.state)
+		return true;
+	
+	char buffer[256];
+	snprintf(buffer, sizeof(buffer), "state hash; %s %016llX, %s %016llX\n",
+			 a.name.c_str(), static_cast<unsigned long long>(Movie::hash(a.state)),
+			 b.name.c_str(), static_cast<unsigned long long>(Movie::hash(b.state)));
+	error = buffer;
+	
+	for(uint32_t address = 0; address <= 0xFFFF; address++) {
+		uint8_t x = a.gb->mmu.peek(static_cast<uint16_t>(address));
+		uint8_t y = b.gb->mmu.peek(static_cast<uint16_t>(address));
+		
+		if(x != y) {
+			snprintf(buffer, sizeof(buffer), "  first at %04X; %s %02X, %s %02X\n", address,
+					 a.name.c_str(), x, b.name.c_str(), y);
+			error += buffer;
+			
+			return false;
+		}
+	}
+	
+	// Somewhere memory doesn't show, IO internals, the PPU, APU..
+	const size_t count = std::min(a.state.size(), b.state.size());
+	size_t offset = 0;
+	
+	while(offset < count && a.state[offset] == b.state[offset]) {
+		offset++;
+	}
+	
+	snprintf(buffer, sizeof(buffer), "  memory matches, first at state offset %zu (of %zu)\n", offset, a.state.size());
+	error += buffer;
+	
+	return false;
+}
+
+static bool run(const std::filesystem::path& path, const Options& options) {
+	RomHandle rom = RomImage::open(path.string());
+	
+	if(!rom || rom->size() < 0x8000) {
+		printf("SKIP  %s (couldn't read)\n", path.string().c_str());
+		
+		return true;
+	}
+	
+	Side a, b;
+	
+	if(!setup(a, options.a, path, rom, options.writes) || !setup(b, options.b, path, rom, options.writes))
+		return true;
+	
+	// WRAM starts out random
+	b.gb->wram = a.gb->wram;
+	
+	const double frame = a.gb->cyclesPerFrame();
+	const uint64_t total = static_cast<uint64_t>(frame * options.frames);
+	
+	// T-Cycles between whole state checks, 0 is every time they meet
+	uint64_t interval = 0;
+	
+	if(options.every == Options::Every::Scanline) interval = static_cast<uint64_t>(frame / 154);
+	if(options.every == Options::Every::Frame) interval = static_cast<uint64_t>(frame);
+	
+	uint64_t nextCheck = interval;
+	uint64_t lastMet = 0;
+	uint64_t meetings = 0;
+	
+	// Where they met last, for context
+	uint16_t recent[8] = {};
+	
+	std::string error;
+	
+	while(true) {
+		const uint64_t x = a.gb->cycles();
+		const uint64_t y = b.gb->cycles();
+		
+		if(x != y) {
+			// Something's skipping ahead differently, or taking different paths
+			if(std::min(x, y) - lastMet > static_cast<uint64_t>(frame)) {
+				char buffer[128];
+				snprintf(buffer, sizeof(buffer), "haven't met for a frame; %s is at %llu, %s at %llu\n",
+						 a.name.c_str(), static_cast<unsigned long long>(x),
+						 b.name.c_str(), static_cast<unsigned long long>(y));
+				error = buffer;
+				
+				break;
+			}
+			
+			if(x < y) a.gb->step();
+			else b.gb->step();
+			
+			continue;
+		}
+		
+		lastMet = x;
+		recent[meetings++ % 8] = a.gb->cpu.PC;
+		
+		if(!sameRegisters(a, b, error) || !sameWrites(a, b, error))
+			break;
+		
+		a.writes.clear();
+		b.writes.clear();
+		
+		if(x >= nextCheck || x >= total) {
+			if(!sameState(a, b, error))
+				break;
+			
+			nextCheck = interval == 0 ? x : (x / interval + 1) * interval;
+		}
+		
+		if(x >= total)
+			break;
+		
+		a.gb->step();
+	}
+	
+	if(!error.empty()) {
+		printf("FAIL  %s at cycle %llu, after %llu meetings\n  %s", path.string().c_str(),
+			   static_cast<unsigned long long>(lastMet), static_cast<unsigned long long>(meetings), error.c_str());
+		
+		std::string registers;
+		dumpRegisters(a, registers);
+		dumpRegisters(b, registers);
+		printf("%s", registers.c_str());
+		
+		printf("  last PCs;");
+		
+		for(uint64_t i = meetings > 8 ? meetings - 8 : 0; i < meetings; i++) {
+			printf(" %04X", recent[i % 8]);
+		}
+		
+		printf("\n");
+		
+		return false;
+	}
+	
+	printf("OK    %s (%llu meetings)\n", path.string().c_str(), static_cast<unsigned long long>(meetings));
+	
+	return true;
+}
+
+int main(int argc, char* argv[]) {
+	Options options;
+	std::vector<std::filesystem::path> paths;
+	
+	for(int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		bool hasValue = i + 1 < argc;
+		
+		if(arg == "--list") {
+			for(const Core& core : CORES) {
+				printf("%-12s - %s\n", core.name, core.description);
+			}
+			
+			return 0;
+		} else if(arg == "--a" && hasValue) {
+			options.a = argv[++i];
+		} else if(arg == "--b" && hasValue) {
+			options.b = argv[++i];
+		} else if(arg == "--frames" && hasValue && std::isdigit(static_cast<unsigned char>(argv[i + 1][0]))) {
+			options.frames = static_cast<uint32_t>(std::stoul(argv[++i]));
+		} else if(arg == "--writes") {
+			options.writes = true;
+		} else if(arg == "--every" && hasValue) {
+			std::string every = argv[++i];
+			
+			if(every == "instruction") options.every = Options::Every::Instruction;
+			else if(every == "scanline") options.every = Options::Every::Scanline;
+			else if(every == "frame") options.every = Options::Every::Frame;
+			else {
+				printf("--every takes instruction, scanline or frame\n");
+				return 1;
+			}
+		} else if(arg.rfind("--", 0) == 0) {
+			printf("Unknown option %s\n", arg.c_str());
+			return 1;
+		} else {
+			paths.emplace_back(arg);
+		}
+	}
+	
+	// Catch typos before running anything
+	std::vector<const Core*> cores;
+	
+	if(!parseCores(options.a, cores) || !parseCores(options.b, cores))
+		return 1;
+	
+	if(paths.empty())
+		paths.emplace_back("Roms/tests");
+	
+	std::vector<std::filesystem::path> roms;
+	
+	for(const auto& path : paths) {
+		if(std::filesystem::is_directory(path)) {
+			for(const auto& entry : std::filesystem::recursive_directory_iterator(path)) {
+				auto extension = entry.path().extension();
+				
+				if(extension == ".gb" || extension == ".gbc")
+					roms.push_back(entry.path());
+			}
+		} else if(std::filesystem::exists(path)) {
+			roms.push_back(path);
+		} else {
+			printf("Can't find %s\n", path.string().c_str());
+		}
+	}
+	
+	if(roms.empty()) {
+		printf("No ROMs to run\n");
+		
+		return 1;
+	}
+	
+	printf("%s vs %s\n\n", options.a.c_str(), options.b.c_str());
+	
+	int failed = 0;
+	
+	for(const auto& rom : roms) {
+		if(!run(rom, options))
+			failed++;
+	}
+	
+	printf("\n%d/%zu ROMs match\n", static_cast<int>(roms.size()) - failed, roms.size());
+	
+	return failed == 0 ? 0 : 1;
+}
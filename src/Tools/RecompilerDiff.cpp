@@ -0,0 +1,207 @@
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Core/GameBoy.h"
+
+/**
+ * Runs every ROM on both CPU backends in lockstep,
+ * and reports the first point where they don't agree.
+ *
+ * The recompiler runs a block, then the interpreter catches up,
+ * to the same cycle; both have to land on the same cycle,
+ * with the same registers. Memory and the screen are compared,
+ * every so often and at the end.
+ *
+ * Usage: gb_recompiler_diff [frames] [rom/directory...]
+ * Defaults to 600 frames of everything in Roms/tests.
+ */
+
+static std::vector<uint8_t> readFile(const std::filesystem::path& path) {
+	std::ifstream stream(path, std::ios::binary);
+	
+	return std::vector<uint8_t>(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+}
+
+static bool sameRegisters(GameBoy& a, GameBoy& b, std::string& error) {
+	CPU& x = a.cpu;
+	CPU& y = b.cpu;
+	
+	char buffer[256];
+	
+	if(x.PC != y.PC || x.SP != y.SP || x.AF.get() != y.AF.get() || x.BC.get() != y.BC.get()
+		|| x.DE.get() != y.DE.get() || x.HL.get() != y.HL.get()
+		|| a.interruptHandler.IME != b.interruptHandler.IME || a.interruptHandler.IF != b.interruptHandler.IF
+		|| x.halted != y.halted) {
+		snprintf(buffer, sizeof(buffer),
+				 "interpreter PC=%04X SP=%04X AF=%04X BC=%04X HL=%04X IF=%02X\n"
+				 "  recompiler  PC=%04X SP=%04X AF=%04X BC=%04X HL=%04X IF=%02X",
+				 x.PC, x.SP, x.AF.get(), x.BC.get(), x.HL.get(), a.interruptHandler.IF,
+				 y.PC, y.SP, y.AF.get(), y.BC.get(), y.HL.get(), b.interruptHandler.IF);
+		error = buffer;
+		
+		return false;
+	}
+	
+	return true;
+}
+
+static bool sameMemory(GameBoy& a, GameBoy& b, std::string& error) {
+	for(uint32_t address = 0x8000; address <= 0xFFFE; address++) {
+		// Echo RAM, unusable area and IO
+		if(address >= 0xE000 && address < 0xFE00)
+			continue;
+		
+		if(address >= 0xFEA0 && address < 0xFF80)
+			continue;
+		
+		uint8_t x = a.mmu.fetch8(static_cast<uint16_t>(address));
+		uint8_t y = b.mmu.fetch8(static_cast<uint16_t>(address));
+		
+		if(x != y) {
+			char buffer[128];
+			snprintf(buffer, sizeof(buffer), "memory at %04X; interpreter %02X, recompiler %02X", address, x, y);
+			error = buffer;
+			
+			return false;
+		}
+	}
+	
+	if(std::memcmp(a.ppu.pixels, b.ppu.pixels, sizeof(a.ppu.pixels)) != 0) {
+		error = "screens differ";
+		
+		return false;
+	}
+	
+	return true;
+}
+
+static bool diff(const std::filesystem::path& path, uint32_t frames) {
+	std::vector<uint8_t> rom = readFile(path);
+	std::vector<uint8_t> bootRom(256, 0);
+	
+	if(rom.size() < 0x8000) {
+		printf("SKIP  %s (couldn't read)\n", path.string().c_str());
+		
+		return true;
+	}
+	
+	auto interpreter = std::make_unique<GameBoy>(rom, bootRom);
+	auto recompiler = std::make_unique<GameBoy>(rom, bootRom);
+	
+	// WRAM starts out random
+	recompiler->wram = interpreter->wram;
+	
+	if(!recompiler->setBackend(Backend::Recompiler)) {
+		printf("SKIP  %s (recompiler not available)\n", path.string().c_str());
+		
+		return true;
+	}
+	
+	const uint64_t total = static_cast<uint64_t>(interpreter->cyclesPerFrame() * frames);
+	
+	uint64_t interpreterCycles = 0;
+	uint64_t recompilerCycles = 0;
+	uint64_t steps = 0;
+	
+	std::string error;
+	
+	while(recompilerCycles < total) {
+		recompilerCycles += recompiler->step();
+		
+		while(interpreterCycles < recompilerCycles) {
+			interpreterCycles += interpreter->step();
+		}
+		
+		steps++;
+		
+		if(interpreterCycles != recompilerCycles) {
+			char buffer[128];
+			snprintf(buffer, sizeof(buffer), "interpreter is at cycle %llu, recompiler at %llu",
+					 static_cast<unsigned long long>(interpreterCycles), static_cast<unsigned long long>(recompilerCycles));
+			error = buffer;
+			
+			break;
+		}
+		
+		if(!sameRegisters(*interpreter, *recompiler, error))
+			break;
+		
+		// Memory is a lot slower to compare
+		if((steps % 100000) == 0 && !sameMemory(*interpreter, *recompiler, error))
+			break;
+	}
+	
+	if(error.empty())
+		sameMemory(*interpreter, *recompiler, error);
+	
+	if(!error.empty()) {
+		printf("FAIL  %s at cycle %llu\n  %s\n", path.string().c_str(),
+			   static_cast<unsigned long long>(recompilerCycles), error.c_str());
+		
+		return false;
+	}
+	
+	printf("OK    %s (%llu blocks compiled, %llu run)\n", path.string().c_str(),
+		   static_cast<unsigned long long>(recompiler->recompiler->blocksCompiled),
+		   static_cast<unsigned long long>(recompiler->recompiler->blocksRun));
+	
+	return true;
+}
+
+int main(int argc, char* argv[]) {
+	uint32_t frames = 600;
+	std::vector<std::filesystem::path> paths;
+	
+	for(int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		
+		if(!arg.empty() && std::isdigit(static_cast<unsigned char>(arg[0])) && !std::filesystem::exists(arg)) {
+			frames = static_cast<uint32_t>(std::stoul(arg));
+		} else {
+			paths.emplace_back(arg);
+		}
+	}
+	
+	if(paths.empty())
+		paths.emplace_back("Roms/tests");
+	
+	std::vector<std::filesystem::path> roms;
+	
+	for(const auto& path : paths) {
+		if(std::filesystem::is_directory(path)) {
+			for(const auto& entry : std::filesystem::recursive_directory_iterator(path)) {
+				auto extension = entry.path().extension();
+				
+				if(extension == ".gb" || extension == ".gbc")
+					roms.push_back(entry.path());
+			}
+		} else if(std::filesystem::exists(path)) {
+			roms.push_back(path);
+		} else {
+			printf("Can't find %s\n", path.string().c_str());
+		}
+	}
+	
+	if(roms.empty()) {
+		printf("No ROMs to run\n");
+		
+		return 1;
+	}
+	
+	int failed = 0;
+	
+	for(const auto& rom : roms) {
+		if(!diff(rom, frames))
+			failed++;
+	}
+	
+	printf("\n%d/%zu ROMs match\n", static_cast<int>(roms.size()) - failed, roms.size());
+	
+	return failed == 0 ? 0 : 1;
+}
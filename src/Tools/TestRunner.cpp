@@ -0,0 +1,578 @@
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <io.h>
+#define dup _dup
+#define fdopen _fdopen
+#define fileno _fileno
+#else
+#include <unistd.h>
+#endif
+
+#include "Core/GameBoy.h"
+#include "Core/Movie.h"
+
+/**
+ * Runs every test ROM headless, on every core, and says which pass.
+ *
+ * A ROM passes or fails by whichever of these it uses first;
+ *   mooneye - B C D E H L are 3 5 8 13 21 34 (0x42 everywhere on failure)
+ *   serial  - blargg's text over the link port, "Passed"/"Failed"
+ *   blargg  - blargg's $A000 status in cartridge RAM (signature DE B0 61)
+ *   hash    - the screen after some frames matches a known hash,
+ *             for the ones that only draw their result (acid2..)
+ * Anything else runs until '--frames' and times out.
+ *
+ * Hashes come from a file ('--hashes'), one ROM per line;
+ *   <hash> <frames> <path, as it's found>
+ * '--write-hashes' writes one for every ROM that timed out,
+ * with what's on screen at the end, so once a screen is checked
+ * by hand as correct it can be kept as the reference.
+ *
+ * Usage: gb_testrunner [options] [rom/directory...]
+ *   -j n                  - Threads (every core)
+ *   --frames n            - When to give up on a ROM (1800, 30 seconds)
+ *   --hashes file         - Known screen hashes
+ *   --write-hashes file   - Screens of the ones that timed out
+ *   --json file           - Report, with the time each ROM took
+ *   --junit file          - Same, as JUnit XML for CI
+ *   --recompiler          - Run them on the recompiler
+ *   --verbose             - Let the emulator print (it's silenced otherwise)
+ * Defaults to everything in Roms/tests.
+ */
+
+enum class Verdict {
+	Pass,
+	Fail,
+	Timeout,
+	Error
+};
+
+static const char* verdictName(Verdict verdict) {
+	switch(verdict) {
+		case Verdict::Pass: return "pass";
+		case Verdict::Fail: return "fail";
+		case Verdict::Timeout: return "timeout";
+		default: return "error";
+	}
+}
+
+struct Expected {
+	uint64_t hash = 0;
+	uint32_t frames = 0;
+};
+
+struct Result {
+	std::filesystem::path path;
+	Verdict verdict = Verdict::Error;
+	
+	// What decided it; mooneye, serial, blargg, hash or nothing
+	std::string method = "none";
+	std::string message;
+	
+	uint32_t frames = 0;
+	double seconds = 0;
+	
+	// What was on screen at the end
+	uint64_t hash = 0;
+};
+
+struct Options {
+	uint32_t threads = 0;
+	uint32_t frames = 1800;
+	
+	std::string hashes;
+	std::string writeHashes;
+	std::string json;
+	std::string junit;
+	
+	bool recompiler = false;
+	bool verbose = false;
+};
+
+// Mooneye's; 3 5 8 13 21 34 to pass, all 0x42 to fail
+static bool checkMooneye(GameBoy& gb, Result& result) {
+	CPU& cpu = gb.cpu;
+	const uint8_t registers[] = { cpu.BC.B, cpu.BC.C, cpu.DE.D, cpu.DE.E, cpu.HL.H, cpu.HL.L };
+	
+	static const uint8_t PASS[] = { 3, 5, 8, 13, 21, 34 };
+	static const uint8_t FAIL[] = { 0x42, 0x42, 0x42, 0x42, 0x42, 0x42 };
+	
+	if(std::memcmp(registers, PASS, sizeof(PASS)) == 0) {
+		result.verdict = Verdict::Pass;
+	} else if(std::memcmp(registers, FAIL, sizeof(FAIL)) == 0) {
+		result.verdict = Verdict::Fail;
+	} else {
+		return false;
+	}
+	
+	result.method = "mooneye";
+	
+	return true;
+}
+
+static bool checkSerial(const std::string& output, Result& result) {
+	if(output.find("Passed") != std::string::npos) {
+		result.verdict = Verdict::Pass;
+	} else if(output.find("Failed") != std::string::npos) {
+		result.verdict = Verdict::Fail;
+	} else {
+		return false;
+	}
+	
+	result.method = "serial";
+	result.message = output;
+	
+	return true;
+}
+
+/**
+ * Blargg's newer tests also keep their state in cartridge RAM;
+ * $A000 is 0x80 while running, then the result code (0 passed),
+ * $A001-$A003 are DE B0 61 and the text is from $A004.
+ */
+static bool checkBlargg(GameBoy& gb, Result& result) {
+	MMU& mmu = gb.mmu;
+	
+	if(mmu.peek(0xA001) != 0xDE || mmu.peek(0xA002) != 0xB0 || mmu.peek(0xA003) != 0x61)
+		return false;
+	
+	const uint8_t status = mmu.peek(0xA000);
+	
+	if(status == 0x80)
+		return false;
+	
+	result.verdict = status == 0 ? Verdict::Pass : Verdict::Fail;
+	result.method = "blargg";
+	result.message.clear();
+	
+	for(uint16_t address = 0xA004; address < 0xC000; address++) {
+		const char c = static_cast<char>(mmu.peek(address));
+		
+		if(c == 0)
+			break;
+		
+		result.message += c;
+	}
+	
+	return true;
+}
+
+static const size_t MAX_OUTPUT = 4096;
+
+// Where the runner itself prints, see 'silenceEmulator'
+static FILE* console = stdout;
+
+static uint64_t screenHash(GameBoy& gb) {
+	return Movie::hash(reinterpret_cast<const uint8_t*>(gb.ppu.pixels), sizeof(gb.ppu.pixels));
+}
+
+static Result run(const std::filesystem::path& path, const Options& options, const Expected* expected) {
+	auto start = std::chrono::steady_clock::now();
+	
+	Result result;
+	result.path = path;
+	
+	RomHandle rom = RomImage::open(path.string());
+	
+	if(!rom || rom->size() < 0x8000) {
+		result.message = "couldn't read the ROM";
+		return result;
+	}
+	
+	GameBoy gb(rom, std::vector<uint8_t>(256, 0));
+	
+	// Same garbage every run, so screens hash the same
+	gb.wram.randomize(0);
+	gb.apu.output = false;
+	
+	if(options.recompiler)
+		gb.setBackend(Backend::Recompiler);
+	
+	std::string output;
+	
+	// Acts like nothing's on the other end
+	gb.serial.set_callback([&output](uint8_t value) -> std::optional<uint8_t> {
+		// Something stuck sending forever shouldn't end up in the report
+		if(output.size() < MAX_OUTPUT)
+			output += static_cast<char>(value);
+		
+		return 0xFF;
+	});
+	
+	const uint32_t frames = expected ? expected->frames : options.frames;
+	
+	// Blargg's text keeps coming for a bit after "Failed"
+	uint32_t settling = 0;
+	bool decided = false;
+	
+	while(result.frames < frames) {
+		// Only the screen that gets hashed is drawn
+		gb.ppu.render = result.frames + 1 == frames;
+		gb.runFrame();
+		result.frames++;
+		
+		if(decided) {
+			result.message = output;
+			
+			if(--settling == 0)
+				break;
+		} else if(!expected) {
+			decided = checkMooneye(gb, result) || checkSerial(output, result) || checkBlargg(gb, result);
+			
+			if(!decided)
+				continue;
+			
+			if(result.verdict != Verdict::Fail || result.method != "serial")
+				break;
+			
+			settling = 30;
+		}
+	}
+	
+	if(!decided) {
+		result.hash = screenHash(gb);
+		
+		if(expected) {
+			result.method = "hash";
+			result.verdict = result.hash == expected->hash ? Verdict::Pass : Verdict::Fail;
+			
+			if(result.verdict == Verdict::Fail) {
+				char buffer[64];
+				snprintf(buffer, sizeof(buffer), "screen hash %016llX", static_cast<unsigned long long>(result.hash));
+				result.message = buffer;
+			}
+		} else {
+			result.verdict = Verdict::Timeout;
+			result.message = output;
+		}
+	}
+	
+	result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	
+	return result;
+}
+
+static std::map<std::string, Expected> readHashes(const std::string& path) {
+	std::map<std::string, Expected> hashes;
+	std::ifstream stream(path);
+	
+	if(!stream) {
+		fprintf(console, "Can't read %s\n", path.c_str());
+		return hashes;
+	}
+	
+	std::string line;
+	uint32_t number = 0;
+	
+	while(std::getline(stream, line)) {
+		number++;
+		
+		if(line.empty() || line[0] == '#')
+			continue;
+		
+		std::istringstream fields(line);
+		std::string hash;
+		Expected expected;
+		
+		if(!(fields >> hash >> expected.frames))
+			continue;
+		
+		// A hand edited line can be anything, so it's skipped rather than taking everything down
+		char* end = nullptr;
+		expected.hash = std::strtoull(hash.c_str(), &end, 16);
+		
+		if(hash.size() > 16 || !std::isxdigit(static_cast<unsigned char>(hash[0])) || end != hash.c_str() + hash.size()) {
+			fprintf(console, "%s:%u; '%s' isn't a hash, skipping the line\n", path.c_str(), number, hash.c_str());
+			continue;
+		}
+		
+		// Paths can have spaces, so it's the rest of the line
+		std::string rom;
+		std::getline(fields >> std::ws, rom);
+		
+		hashes[rom] = expected;
+	}
+	
+	return hashes;
+}
+
+static void writeHashes(const std::string& path, const std::vector<Result>& results, uint32_t frames) {
+	FILE* file = fopen(path.c_str(), "w");
+	
+	if(!file) {
+		fprintf(console, "Can't write to %s\n", path.c_str());
+		return;
+	}
+	
+	fprintf(file, "# <hash> <frames> <rom>, screens after the ROM ran that many frames\n");
+	
+	for(const Result& result : results) {
+		if(result.verdict == Verdict::Timeout || result.method == "hash") {
+			fprintf(file, "%016llX %u %s\n", static_cast<unsigned long long>(result.hash),
+					result.method == "hash" ? result.frames : frames, result.path.generic_string().c_str());
+		}
+	}
+	
+	fclose(file);
+}
+
+static std::string escape(const std::string& text, bool xml) {
+	std::string out;
+	
+	for(char c : text) {
+		const unsigned char u = static_cast<unsigned char>(c);
+		
+		if(xml) {
+			if(c == '<') out += "&lt;";
+			else if(c == '>') out += "&gt;";
+			else if(c == '&') out += "&amp;";
+			else if(c == '"') out += "&quot;";
+			else if(u < 0x20 && c != '\n' && c != '\t') out += ' ';
+			else out += c;
+		} else {
+			if(c == '"' || c == '\\') {
+				out += '\\';
+				out += c;
+			} else if(u < 0x20 || u >= 0x7F) {
+				char buffer[8];
+				snprintf(buffer, sizeof(buffer), "\\u%04x", u);
+				out += buffer;
+			} else {
+				out += c;
+			}
+		}
+	}
+	
+	return out;
+}
+
+static void writeJson(const std::string& path, const std::vector<Result>& results, double seconds) {
+	FILE* file = fopen(path.c_str(), "w");
+	
+	if(!file) {
+		fprintf(console, "Can't write to %s\n", path.c_str());
+		return;
+	}
+	
+	size_t passed = std::count_if(results.begin(), results.end(), [](const Result& r) { return r.verdict == Verdict::Pass; });
+	
+	fprintf(file, "{\n  \"total\": %zu,\n  \"passed\": %zu,\n  \"seconds\": %.3f,\n  \"roms\": [\n",
+			results.size(), passed, seconds);
+	
+	for(size_t i = 0; i < results.size(); i++) {
+		const Result& result = results[i];
+		
+		fprintf(file, "    { \"path\": \"%s\", \"result\": \"%s\", \"method\": \"%s\", \"frames\": %u, \"seconds\": %.3f, "
+				"\"hash\": \"%016llX\", \"message\": \"%s\" }%s\n",
+				escape(result.path.generic_string(), false).c_str(), verdictName(result.verdict), result.method.c_str(),
+				result.frames, result.seconds, static_cast<unsigned long long>(result.hash),
+				escape(result.message, false).c_str(), i + 1 < results.size() ? "," : "");
+	}
+	
+	fprintf(file, "  ]\n}\n");
+	fclose(file);
+}
+
+static void writeJunit(const std::string& path, const std::vector<Result>& results, double seconds) {
+	FILE* file = fopen(path.c_str(), "w");
+	
+	if(!file) {
+		fprintf(console, "Can't write to %s\n", path.c_str());
+		return;
+	}
+	
+	size_t failures = 0;
+	size_t errors = 0;
+	
+	for(const Result& result : results) {
+		if(result.verdict == Verdict::Fail || result.verdict == Verdict::Timeout) failures++;
+		if(result.verdict == Verdict::Error) errors++;
+	}
+	
+	fprintf(file, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+	fprintf(file, "<testsuite name=\"gb_testrunner\" tests=\"%zu\" failures=\"%zu\" errors=\"%zu\" time=\"%.3f\">\n",
+			results.size(), failures, errors, seconds);
+	
+	for(const Result& result : results) {
+		fprintf(file, "  <testcase classname=\"%s\" name=\"%s\" time=\"%.3f\"",
+				escape(result.path.parent_path().generic_string(), true).c_str(),
+				escape(result.path.filename().string(), true).c_str(), result.seconds);
+		
+		if(result.verdict == Verdict::Pass) {
+			fprintf(file, "/>\n");
+			continue;
+		}
+		
+		const char* tag = result.verdict == Verdict::Error ? "error" : "failure";
+		
+		fprintf(file, ">\n    <%s message=\"%s (%s)\">%s</%s>\n  </testcase>\n", tag, verdictName(result.verdict),
+				result.method.c_str(), escape(result.message, true).c_str(), tag);
+	}
+	
+	fprintf(file, "</testsuite>\n");
+	fclose(file);
+}
+
+/**
+ * The emulator prints all over stdout/stderr (cartridge info, unknown IO..),
+ * which is a mess with everything running at once,
+ * so those go nowhere, and 'console' is the real stdout.
+ */
+static void silenceEmulator() {
+#ifdef _WIN32
+	static const char* NOWHERE = "NUL";
+#else
+	static const char* NOWHERE = "/dev/null";
+#endif
+
+	fflush(stdout);
+	fflush(stderr);
+	
+	FILE* out = fdopen(dup(fileno(stdout)), "w");
+	
+	if(!out)
+		return;
+	
+	console = out;
+	
+	if(!freopen(NOWHERE, "w", stdout) || !freopen(NOWHERE, "w", stderr))
+		fprintf(console, "Couldn't silence the emulator\n");
+}
+
+int main(int argc, char* argv[]) {
+	Options options;
+	std::vector<std::filesystem::path> paths;
+	
+	for(int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		bool hasValue = i + 1 < argc;
+		
+		if(arg == "-j" && hasValue) {
+			options.threads = static_cast<uint32_t>(std::stoul(argv[++i]));
+		} else if(arg == "--frames" && hasValue) {
+			options.frames = static_cast<uint32_t>(std::stoul(argv[++i]));
+		} else if(arg == "--hashes" && hasValue) {
+			options.hashes = argv[++i];
+		} else if(arg == "--write-hashes" && hasValue) {
+			options.writeHashes = argv[++i];
+		} else if(arg == "--json" && hasValue) {
+			options.json = argv[++i];
+		} else if(arg == "--junit" && hasValue) {
+			options.junit = argv[++i];
+		} else if(arg == "--recompiler") {
+			options.recompiler = true;
+		} else if(arg == "--verbose") {
+			options.verbose = true;
+		} else if(arg.rfind("-", 0) == 0) {
+			printf("Unknown option %s\n", arg.c_str());
+			return 1;
+		} else {
+			paths.emplace_back(arg);
+		}
+	}
+	
+	if(paths.empty())
+		paths.emplace_back("Roms/tests");
+	
+	std::vector<std::filesystem::path> roms;
+	
+	for(const auto& path : paths) {
+		if(std::filesystem::is_directory(path)) {
+			for(const auto& entry : std::filesystem::recursive_directory_iterator(path)) {
+				auto extension = entry.path().extension();
+				
+				if(extension == ".gb" || extension == ".gbc")
+					roms.push_back(entry.path());
+			}
+		} else if(std::filesystem::exists(path)) {
+			roms.push_back(path);
+		} else {
+			printf("Can't find %s\n", path.string().c_str());
+		}
+	}
+	
+	if(roms.empty()) {
+		printf("No ROMs to run\n");
+		
+		return 1;
+	}
+	
+	std::sort(roms.begin(), roms.end());
+	
+	std::map<std::string, Expected> hashes;
+	
+	if(!options.hashes.empty())
+		hashes = readHashes(options.hashes);
+	
+	if(!options.verbose)
+		silenceEmulator();
+	
+	uint32_t threads = options.threads;
+	
+	if(threads == 0)
+		threads = std::max(1u, std::thread::hardware_concurrency());
+	
+	threads = std::min<uint32_t>(threads, static_cast<uint32_t>(roms.size()));
+	
+	auto start = std::chrono::steady_clock::now();
+	
+	std::vector<Result> results(roms.size());
+	std::atomic<size_t> next { 0 };
+	std::mutex printing;
+	
+	auto worker = [&]() {
+		for(size_t i = next++; i < roms.size(); i = next++) {
+			auto it = hashes.find(roms[i].generic_string());
+			results[i] = run(roms[i], options, it != hashes.end() ? &it->second : nullptr);
+			
+			std::lock_guard<std::mutex> lock(printing);
+			fprintf(console, "%-8s %-8s %7.2fs  %s\n", verdictName(results[i].verdict), results[i].method.c_str(),
+					results[i].seconds, roms[i].generic_string().c_str());
+			fflush(console);
+		}
+	};
+	
+	std::vector<std::thread> pool;
+	
+	for(uint32_t i = 1; i < threads; i++) {
+		pool.emplace_back(worker);
+	}
+	
+	worker();
+	
+	for(std::thread& thread : pool) {
+		thread.join();
+	}
+	
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	
+	size_t counts[4] = {};
+	
+	for(const Result& result : results) {
+		counts[static_cast<int>(result.verdict)]++;
+	}
+	
+	fprintf(console, "\n%zu/%zu passed, %zu failed, %zu timed out, %zu errors, %.2fs on %u threads\n",
+			counts[0], results.size(), counts[1], counts[2], counts[3], seconds, threads);
+	
+	if(!options.json.empty()) writeJson(options.json, results, seconds);
+	if(!options.junit.empty()) writeJunit(options.junit, results, seconds);
+	if(!options.writeHashes.empty()) writeHashes(options.writeHashes, results, options.frames);
+	
+	return counts[0] == results.size() ? 0 : 1;
+}
@@ -0,0 +1,90 @@
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "Core/Trace.h"
+
+/**
+ * Turns a binary trace (see Trace.h) into gameboy-doctor's text format;
+ * A:01 F:B0 B:00 C:13 D:00 E:D8 H:01 L:4D SP:FFFE PC:0100 PCMEM:00,C3,13,02
+ *
+ * '--extra' adds the bank, cycle, IME and LY after each line,
+ * and the writes each instruction made on the lines after it,
+ * which gameboy-doctor itself doesn't understand.
+ *
+ * Usage: gb_trace_doctor trace [output] [--extra]
+ * Writes to stdout without an output.
+ */
+
+int main(int argc, char* argv[]) {
+	std::string input;
+	std::string output;
+	bool extra = false;
+	
+	for(int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		
+		if(arg == "--extra") {
+			extra = true;
+		} else if(input.empty()) {
+			input = arg;
+		} else if(output.empty()) {
+			output = arg;
+		} else {
+			input.clear();
+			break;
+		}
+	}
+	
+	if(input.empty()) {
+		printf("Usage: gb_trace_doctor trace [output] [--extra]\n");
+		
+		return 1;
+	}
+	
+	TraceReader reader;
+	
+	if(!reader.open(input))
+		return 1;
+	
+	FILE* file = output.empty() ? stdout : fopen(output.c_str(), "w");
+	
+	if(!file) {
+		fprintf(stderr, "Can't write to %s\n", output.c_str());
+		
+		return 1;
+	}
+	
+	TraceRecord record;
+	std::vector<uint32_t> writes;
+	uint64_t count = 0;
+	
+	while(reader.next(record, writes)) {
+		// These belong to the previous instruction
+		if(extra) {
+			for(uint32_t write : writes) {
+				fprintf(file, "  [%04X] = %02X\n", write >> 8, write & 0xFF);
+			}
+		}
+		
+		fprintf(file, "A:%02X F:%02X B:%02X C:%02X D:%02X E:%02X H:%02X L:%02X SP:%04X PC:%04X PCMEM:%02X,%02X,%02X,%02X",
+				record.regs[0], record.regs[1], record.regs[2], record.regs[3],
+				record.regs[4], record.regs[5], record.regs[6], record.regs[7],
+				record.SP, record.PC, record.pcmem[0], record.pcmem[1], record.pcmem[2], record.pcmem[3]);
+		
+		if(extra) {
+			fprintf(file, " BANK:%02X CYCLE:%llu IME:%d LY:%02X", record.bank,
+					static_cast<unsigned long long>(record.cycle), record.IME, record.LY);
+		}
+		
+		fputc('\n', file);
+		count++;
+	}
+	
+	if(file != stdout)
+		fclose(file);
+	
+	fprintf(stderr, "%llu instructions\n", static_cast<unsigned long long>(count));
+	
+	return 0;
+}
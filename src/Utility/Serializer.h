@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+/**
+ * Used for save states.
+ *
+ * Every component has a single 'serialize' that lists its state,
+ * the same function is used for both saving and loading,
+ * so the two can never go out of sync.
+ *
+ * Everything is copied as raw bytes (native endianness),
+ * so states are only meant to be loaded by the same build.
+ */
+
+class Serializer {
+public:
+	// Saving, appends to 'data'
+	explicit Serializer(std::vector<uint8_t>& data) : output(&data) {}
+	
+	// Loading 'size' bytes from 'data'
+	Serializer(const uint8_t* data, size_t size) : input(data), inputSize(size) {}
+	
+	bool isLoading() const { return input != nullptr; }
+	
+	// False once a load ran out of data, or found something that doesn't fit
+	bool good() const { return !failed; }
+	void fail() { failed = true; }
+	
+	template<typename T>
+	void operator()(T& value) {
+		static_assert(std::is_trivially_copyable_v<T>, "Only plain data can be copied as is");
+		
+		bytes(&value, sizeof(T));
+	}
+	
+	void bytes(void* data, size_t size) {
+		if(size == 0)
+			return;
+		
+		if(output) {
+			const uint8_t* begin = static_cast<const uint8_t*>(data);
+			output->insert(output->end(), begin, begin + size);
+			
+			return;
+		}
+		
+		if(failed || inputSize - position < size) {
+			failed = true;
+			return;
+		}
+		
+		std::memcpy(data, input + position, size);
+		position += size;
+	}
+	
+	/**
+	 * Vectors are stored with their size first,
+	 * when loading they have to be the same size as they are now,
+	 * unless 'resize' is set.
+	 */
+	template<typename T>
+	void vector(std::vector<T>& values, bool resize = false) {
+		static_assert(std::is_trivially_copyable_v<T>, "Only plain data can be copied as is");
+		
+		uint32_t size = static_cast<uint32_t>(values.size());
+		(*this)(size);
+		
+		if(isLoading() && size != values.size()) {
+			if(!resize || size > (inputSize - position) / sizeof(T)) {
+				failed = true;
+				return;
+			}
+			
+			values.resize(size);
+		}
+		
+		bytes(values.data(), size * sizeof(T));
+	}
+	
+	size_t offset() const { return output ? output->size() : position; }
+
+private:
+	std::vector<uint8_t>* output = nullptr;
+	
+	const uint8_t* input = nullptr;
+	size_t inputSize = 0;
+	size_t position = 0;
+	
+	bool failed = false;
+};